@@ -0,0 +1,436 @@
+#pragma once
+
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "../defs.hpp"
+#include "../utils/allocator.hpp"
+#include "list.hpp"
+
+namespace prelude {
+
+template<typename Deque, bool Const>
+class deque_iterator;
+
+/**
+ * @brief A double-ended queue over a power-of-two ring buffer. Both ends push and pop in amortized
+ * O(1), positions wrap with a mask instead of a modulo, and growth doubles the buffer and unwraps
+ * the elements into it with at most two bulk relocations. This is the recommended container for
+ * queue<T, Cont>.
+ *
+ * insert and erase in the middle shift the shorter side and are linear.
+ *
+ * @tparam T The element type.
+ * @tparam Alloc The allocator.
+ */
+template<typename T, typename Alloc = prelude::basic_allocator<T>>
+class deque {
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using size_type = prelude::size_t;
+    using pointer_type = T*;
+    using const_pointer_type = T const*;
+    using reference_type = T&;
+    using const_reference_type = T const&;
+    using iterator_type = deque_iterator<deque, false>;
+    using const_iterator_type = deque_iterator<deque, true>;
+
+    static constexpr size_type k_min_capacity = 8;
+
+    constexpr deque() noexcept = default;
+
+    deque(deque const& other)
+        : m_alloc(other.m_alloc) {
+
+        this->reserve(other.m_size);
+        for (size_type i = 0; i < other.m_size; ++i) {
+            ::new(m_data + i) T(other[i]);
+            ++m_size;
+        }
+    }
+
+    deque(deque&& other) noexcept
+        : m_data(other.m_data),
+          m_head(other.m_head),
+          m_size(other.m_size),
+          m_capacity(other.m_capacity),
+          m_alloc(static_cast<Alloc&&>(other.m_alloc)) {
+
+        other.m_data = nullptr;
+        other.m_head = 0;
+        other.m_size = 0;
+        other.m_capacity = 0;
+    }
+
+    ~deque() {
+        this->clear();
+        if (m_data != nullptr) {
+            m_alloc.deallocate(m_data, m_capacity);
+        }
+    }
+
+    deque& operator =(deque const& other) {
+        if (this != &other) {
+            auto tmp = other;
+            swap(*this, tmp);
+        }
+        return *this;
+    }
+
+    deque& operator =(deque&& other) noexcept {
+        auto tmp = static_cast<deque&&>(other);
+        swap(*this, tmp);
+        return *this;
+    }
+
+    static deque from_list(std::initializer_list<T> const& list) {
+        return deque::from_range(list.begin(), list.end());
+    }
+
+    template<typename InIt>
+    static deque from_range(InIt first, InIt last) {
+        auto result = deque();
+        if constexpr (requires { static_cast<size_type>(last - first); }) {
+            result.reserve(static_cast<size_type>(last - first));
+        }
+        while (first != last) {
+            result.emplace_back(*first);
+            ++first;
+        }
+        return result;
+    }
+
+    constexpr T const& back() const {
+        return m_data[this->physical(m_size - 1)];
+    }
+
+    constexpr T& back() {
+        return m_data[this->physical(m_size - 1)];
+    }
+
+    constexpr const_iterator_type begin() const noexcept {
+        return { this, 0 };
+    }
+
+    constexpr iterator_type begin() noexcept {
+        return { this, 0 };
+    }
+
+    constexpr size_type capacity() const noexcept {
+        return m_capacity;
+    }
+
+    constexpr const_iterator_type cbegin() const noexcept {
+        return { this, 0 };
+    }
+
+    constexpr const_iterator_type cend() const noexcept {
+        return { this, m_size };
+    }
+
+    void clear() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_type i = 0; i < m_size; ++i) {
+                m_data[this->physical(i)].~T();
+            }
+        }
+        m_head = 0;
+        m_size = 0;
+    }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (m_size == m_capacity) {
+            // Materialize first, since the arguments may refer into the deque.
+            auto value = T(static_cast<Args&&>(args)...);
+            this->grow(m_size + 1);
+            return *::new(m_data + this->physical(m_size++)) T(static_cast<T&&>(value));
+        }
+        return *::new(m_data + this->physical(m_size++)) T(static_cast<Args&&>(args)...);
+    }
+
+    template<typename... Args>
+    T& emplace_front(Args&&... args) {
+        if (m_size == m_capacity) {
+            auto value = T(static_cast<Args&&>(args)...);
+            this->grow(m_size + 1);
+            m_head = (m_head - 1) & (m_capacity - 1);
+            ++m_size;
+            return *::new(m_data + m_head) T(static_cast<T&&>(value));
+        }
+        auto const head = (m_head - 1) & (m_capacity - 1);
+        auto* result = ::new(m_data + head) T(static_cast<Args&&>(args)...);
+        m_head = head;
+        ++m_size;
+        return *result;
+    }
+
+    constexpr bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    constexpr const_iterator_type end() const noexcept {
+        return { this, m_size };
+    }
+
+    constexpr iterator_type end() noexcept {
+        return { this, m_size };
+    }
+
+    iterator_type erase(const_iterator_type pos) {
+        auto const index = pos.index();
+        if (index < m_size / 2) {
+            for (auto i = index; i > 0; --i) {
+                (*this)[i] = static_cast<T&&>((*this)[i - 1]);
+            }
+            this->pop_front();
+        }
+        else {
+            for (auto i = index; i + 1 < m_size; ++i) {
+                (*this)[i] = static_cast<T&&>((*this)[i + 1]);
+            }
+            this->pop_back();
+        }
+        return { this, index };
+    }
+
+    constexpr T const& front() const {
+        return m_data[m_head];
+    }
+
+    constexpr T& front() {
+        return m_data[m_head];
+    }
+
+    iterator_type insert(const_iterator_type pos) {
+        return this->emplace(pos);
+    }
+
+    iterator_type insert(const_iterator_type pos, T const& val) {
+        return this->emplace(pos, val);
+    }
+
+    iterator_type insert(const_iterator_type pos, T&& val) {
+        return this->emplace(pos, static_cast<T&&>(val));
+    }
+
+    template<typename... Args>
+    iterator_type emplace(const_iterator_type pos, Args&&... args) {
+        auto const index = pos.index();
+        if (index == 0) {
+            this->emplace_front(static_cast<Args&&>(args)...);
+            return { this, index };
+        }
+        if (index == m_size) {
+            this->emplace_back(static_cast<Args&&>(args)...);
+            return { this, index };
+        }
+        // Open a hole at index by shifting the shorter side outwards by one.
+        auto value = T(static_cast<Args&&>(args)...);
+        if (index < m_size / 2) {
+            this->emplace_front(static_cast<T&&>((*this)[0]));
+            for (size_type i = 1; i < index; ++i) {
+                (*this)[i] = static_cast<T&&>((*this)[i + 1]);
+            }
+        }
+        else {
+            this->emplace_back(static_cast<T&&>((*this)[m_size - 1]));
+            for (auto i = m_size - 2; i > index; --i) {
+                (*this)[i] = static_cast<T&&>((*this)[i - 1]);
+            }
+        }
+        (*this)[index] = static_cast<T&&>(value);
+        return { this, index };
+    }
+
+    constexpr bool is_empty() const noexcept {
+        return m_size == 0;
+    }
+
+    void pop_back() {
+        --m_size;
+        m_data[this->physical(m_size)].~T();
+    }
+
+    void pop_front() {
+        m_data[m_head].~T();
+        m_head = (m_head + 1) & (m_capacity - 1);
+        --m_size;
+    }
+
+    void push_back(T const& val) {
+        this->emplace_back(val);
+    }
+
+    void push_back(T&& val) {
+        this->emplace_back(static_cast<T&&>(val));
+    }
+
+    void push_front(T const& val) {
+        this->emplace_front(val);
+    }
+
+    void push_front(T&& val) {
+        this->emplace_front(static_cast<T&&>(val));
+    }
+
+    void reserve(size_type n) {
+        if (n > m_capacity) {
+            this->grow(n);
+        }
+    }
+
+    constexpr size_type size() const noexcept {
+        return m_size;
+    }
+
+    constexpr T const& operator [](size_type i) const {
+        return m_data[this->physical(i)];
+    }
+
+    constexpr T& operator [](size_type i) {
+        return m_data[this->physical(i)];
+    }
+
+    friend void swap(deque& lhs, deque& rhs) noexcept {
+        std::swap(lhs.m_data, rhs.m_data);
+        std::swap(lhs.m_head, rhs.m_head);
+        std::swap(lhs.m_size, rhs.m_size);
+        std::swap(lhs.m_capacity, rhs.m_capacity);
+        std::swap(lhs.m_alloc, rhs.m_alloc);
+    }
+
+private:
+    constexpr size_type physical(size_type i) const noexcept {
+        return (m_head + i) & (m_capacity - 1);
+    }
+
+    // Move to a buffer of at least n slots, rounded up to a power of two. The elements are unwrapped
+    // so that the front lands at slot 0: the run from the head to the end of the old buffer moves
+    // first, then the wrapped-around run from its start.
+    void grow(size_type n) {
+        auto capacity = m_capacity == 0 ? k_min_capacity : m_capacity * 2;
+        while (capacity < n) {
+            capacity *= 2;
+        }
+        auto* data = m_alloc.allocate(capacity);
+        if (m_data != nullptr) {
+            auto const first_run = m_size < m_capacity - m_head ? m_size : m_capacity - m_head;
+            prelude::relocate(m_data + m_head, first_run, data);
+            prelude::relocate(m_data, m_size - first_run, data + first_run);
+            m_alloc.deallocate(m_data, m_capacity);
+        }
+        m_data = data;
+        m_head = 0;
+        m_capacity = capacity;
+    }
+
+    T* m_data = nullptr;
+    size_type m_head = 0;
+    size_type m_size = 0;
+    size_type m_capacity = 0;
+    [[no_unique_address]] Alloc m_alloc = {};
+};
+
+/**
+ * @brief A random access iterator over a deque. It holds the logical index rather than a slot, so
+ * it stays meaningful across the wrap-around point.
+ */
+template<typename Deque, bool Const>
+class deque_iterator {
+public:
+    using container_type = std::conditional_t<Const, Deque const, Deque>;
+    using value_type = Deque::value_type;
+    using size_type = prelude::size_t;
+    using difference_type = prelude::ssize_t;
+    using pointer_type = std::conditional_t<Const, value_type const*, value_type*>;
+    using const_pointer_type = value_type const*;
+    using reference_type = std::conditional_t<Const, value_type const&, value_type&>;
+    using const_reference_type = value_type const&;
+
+    constexpr deque_iterator() noexcept = default;
+
+    constexpr deque_iterator(container_type* deque, size_type index) noexcept
+        : m_deque(deque), m_index(index) {}
+
+    constexpr operator deque_iterator<Deque, true>() const noexcept {
+        return { m_deque, m_index };
+    }
+
+    constexpr size_type index() const noexcept {
+        return m_index;
+    }
+
+    constexpr reference_type operator *() const {
+        return (*m_deque)[m_index];
+    }
+
+    constexpr pointer_type operator ->() const {
+        return &(*m_deque)[m_index];
+    }
+
+    constexpr reference_type operator [](difference_type n) const {
+        return (*m_deque)[m_index + n];
+    }
+
+    constexpr deque_iterator& operator ++() noexcept {
+        ++m_index;
+        return *this;
+    }
+
+    constexpr deque_iterator operator ++(int) noexcept {
+        auto ret = *this;
+        ++m_index;
+        return ret;
+    }
+
+    constexpr deque_iterator& operator --() noexcept {
+        --m_index;
+        return *this;
+    }
+
+    constexpr deque_iterator operator --(int) noexcept {
+        auto ret = *this;
+        --m_index;
+        return ret;
+    }
+
+    constexpr deque_iterator& operator +=(difference_type n) noexcept {
+        m_index += n;
+        return *this;
+    }
+
+    constexpr deque_iterator& operator -=(difference_type n) noexcept {
+        m_index -= n;
+        return *this;
+    }
+
+    constexpr deque_iterator operator +(difference_type n) const noexcept {
+        return { m_deque, m_index + n };
+    }
+
+    constexpr deque_iterator operator -(difference_type n) const noexcept {
+        return { m_deque, m_index - n };
+    }
+
+    constexpr difference_type operator -(deque_iterator const& other) const noexcept {
+        return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+    }
+
+    constexpr bool operator ==(deque_iterator const& other) const noexcept {
+        return m_index == other.m_index;
+    }
+
+    constexpr auto operator <=>(deque_iterator const& other) const noexcept {
+        return m_index <=> other.m_index;
+    }
+
+private:
+    container_type* m_deque = nullptr;
+    size_type m_index = 0;
+};
+
+} // namespace prelude
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
 #include "../defs.hpp"
+#include "../utils/allocator.hpp"
 #include "../utils/meta.hpp"
 
 namespace prelude {
@@ -38,10 +44,409 @@ concept list_type = requires (List list, List const clist) {
     { clist[declval<Size>()] }      -> same_type<CRef>;
 };
 
-template<typename T, typename Alloc>
-class array_list {
+// Uninitialized room for N elements inside the list object itself.
+template<typename T, prelude::size_t N>
+struct inline_storage {
+    T const* data() const noexcept {
+        return reinterpret_cast<T const*>(m_bytes);
+    }
+
+    T* data() noexcept {
+        return reinterpret_cast<T*>(m_bytes);
+    }
+
+private:
+    alignas(T) unsigned char m_bytes[N * sizeof(T)];
+};
+
+template<typename T>
+struct inline_storage<T, 0> {
+    constexpr T const* data() const noexcept {
+        return nullptr;
+    }
+
+    constexpr T* data() noexcept {
+        return nullptr;
+    }
+};
+
+/**
+ * @brief A growable contiguous list. Capacity grows geometrically, and storage is requested through
+ * allocate_at_least when the allocator offers it, so any slack the heap hands out is used before
+ * the next reallocation. Trivially copyable elements are moved around in bulk with memmove.
+ *
+ * The first N elements live inside the list object itself, and the heap is only touched once the
+ * list outgrows them. Use it through the array_list (N = 0) and small_array_list aliases.
+ *
+ * push_front, pop_front and insert shift the tail and are linear; the rest of list_type is O(1).
+ *
+ * @tparam T The element type.
+ * @tparam N The inline capacity.
+ * @tparam Alloc The allocator.
+ */
+template<typename T, prelude::size_t N, typename Alloc>
+class basic_array_list {
+public:
+    using value_type = T;
+    using allocator_type = Alloc;
+    using size_type = prelude::size_t;
+    using pointer_type = T*;
+    using const_pointer_type = T const*;
+    using reference_type = T&;
+    using const_reference_type = T const&;
+    using iterator_type = T*;
+    using const_iterator_type = T const*;
+
+    static constexpr size_type k_inline_capacity = N;
+    static constexpr size_type k_min_capacity = N > 4 ? N : 4;
+
+    basic_array_list() noexcept
+        : m_capacity(N) {
+
+        m_data = m_inline.data();
+    }
+
+    basic_array_list(basic_array_list const& other)
+        : basic_array_list() {
+
+        m_alloc = other.m_alloc;
+        this->reserve(other.m_size);
+        this->append_copy(other.m_data, other.m_size);
+    }
+
+    basic_array_list(basic_array_list&& other) noexcept
+        : basic_array_list() {
+
+        this->steal(other);
+    }
+
+    ~basic_array_list() {
+        this->clear();
+        this->release();
+    }
+
+    basic_array_list& operator =(basic_array_list const& other) {
+        if (this != &other) {
+            auto tmp = other;
+            *this = static_cast<basic_array_list&&>(tmp);
+        }
+        return *this;
+    }
+
+    basic_array_list& operator =(basic_array_list&& other) noexcept {
+        if (this != &other) {
+            this->clear();
+            this->release();
+            this->steal(other);
+        }
+        return *this;
+    }
+
+    static basic_array_list from_list(std::initializer_list<T> const& list) {
+        return basic_array_list::from_range(list.begin(), list.end());
+    }
+
+    /**
+     * @brief Build a list from a range. When the length of the range can be computed up front, the
+     * storage is allocated exactly once.
+     */
+    template<typename InIt>
+    static basic_array_list from_range(InIt first, InIt last) {
+        auto result = basic_array_list();
+        if constexpr (requires { static_cast<size_type>(last - first); }) {
+            result.reserve(static_cast<size_type>(last - first));
+        }
+        while (first != last) {
+            result.emplace_back(*first);
+            ++first;
+        }
+        return result;
+    }
+
+    constexpr T const& back() const {
+        return m_data[m_size - 1];
+    }
+
+    constexpr T& back() {
+        return m_data[m_size - 1];
+    }
+
+    constexpr T const* begin() const noexcept {
+        return m_data;
+    }
+
+    constexpr T* begin() noexcept {
+        return m_data;
+    }
+
+    constexpr size_type capacity() const noexcept {
+        return m_capacity;
+    }
+
+    constexpr T const* cbegin() const noexcept {
+        return m_data;
+    }
+
+    constexpr T const* cend() const noexcept {
+        return m_data + m_size;
+    }
+
+    void clear() noexcept {
+        prelude::destroy(m_data, m_data + m_size);
+        m_size = 0;
+    }
+
+    constexpr T const* data() const noexcept {
+        return m_data;
+    }
+
+    constexpr T* data() noexcept {
+        return m_data;
+    }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (m_size == m_capacity) {
+            // The arguments may refer into the list, so construct into the new storage first.
+            auto const grown = this->next_capacity(m_size + 1);
+            auto const result = this->allocate(grown);
+            ::new(result.ptr + m_size) T(static_cast<Args&&>(args)...);
+            this->adopt(result);
+        }
+        else {
+            ::new(m_data + m_size) T(static_cast<Args&&>(args)...);
+        }
+        return m_data[m_size++];
+    }
+
+    template<typename... Args>
+    T* emplace(T const* pos, Args&&... args) {
+        auto const index = static_cast<size_type>(pos - m_data);
+        if (index == m_size) {
+            this->emplace_back(static_cast<Args&&>(args)...);
+            return m_data + index;
+        }
+        // Materialize the value first, since the arguments may refer into the list.
+        auto value = T(static_cast<Args&&>(args)...);
+        if (m_size == m_capacity) {
+            this->reserve(this->next_capacity(m_size + 1));
+        }
+        prelude::relocate(m_data + index, m_size - index, m_data + index + 1);
+        ::new(m_data + index) T(static_cast<T&&>(value));
+        ++m_size;
+        return m_data + index;
+    }
 
+    constexpr bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    constexpr T const* end() const noexcept {
+        return m_data + m_size;
+    }
+
+    constexpr T* end() noexcept {
+        return m_data + m_size;
+    }
+
+    T* erase(T const* pos) {
+        return this->erase(pos, pos + 1);
+    }
+
+    T* erase(T const* first, T const* last) {
+        auto* const from = m_data + (first - m_data);
+        auto* const to = m_data + (last - m_data);
+        prelude::destroy(from, to);
+        prelude::relocate(to, static_cast<size_type>(m_data + m_size - to), from);
+        m_size -= static_cast<size_type>(to - from);
+        return from;
+    }
+
+    constexpr T const& front() const {
+        return m_data[0];
+    }
+
+    constexpr T& front() {
+        return m_data[0];
+    }
+
+    T* insert(T const* pos) {
+        return this->emplace(pos);
+    }
+
+    T* insert(T const* pos, T const& val) {
+        return this->emplace(pos, val);
+    }
+
+    T* insert(T const* pos, T&& val) {
+        return this->emplace(pos, static_cast<T&&>(val));
+    }
+
+    constexpr bool is_empty() const noexcept {
+        return m_size == 0;
+    }
+
+    void pop_back() {
+        m_data[--m_size].~T();
+    }
+
+    void pop_front() {
+        this->erase(m_data);
+    }
+
+    void push_back(T const& val) {
+        this->emplace_back(val);
+    }
+
+    void push_back(T&& val) {
+        this->emplace_back(static_cast<T&&>(val));
+    }
+
+    void push_front(T const& val) {
+        this->emplace(m_data, val);
+    }
+
+    void push_front(T&& val) {
+        this->emplace(m_data, static_cast<T&&>(val));
+    }
+
+    // Make room for at least n elements without reallocating.
+    void reserve(size_type n) {
+        if (n > m_capacity) {
+            this->adopt(this->allocate(n));
+        }
+    }
+
+    // Give back unused capacity, moving back into the inline buffer if the elements fit.
+    void shrink_to_fit() {
+        if (m_size == m_capacity || this->is_inline()) {
+            return;
+        }
+        if (m_size == 0) {
+            this->release();
+            return;
+        }
+        if constexpr (N > 0) {
+            if (m_size <= N) {
+                auto* heap = m_data;
+                auto const capacity = m_capacity;
+                m_data = m_inline.data();
+                m_capacity = N;
+                prelude::relocate(heap, m_size, m_data);
+                m_alloc.deallocate(heap, capacity);
+                return;
+            }
+        }
+        this->adopt(allocation_result<T*> { m_alloc.allocate(m_size), m_size });
+    }
+
+    constexpr size_type size() const noexcept {
+        return m_size;
+    }
+
+    constexpr T const& operator [](size_type i) const {
+        return m_data[i];
+    }
+
+    constexpr T& operator [](size_type i) {
+        return m_data[i];
+    }
+
+    // Whether the elements currently live in the inline buffer.
+    constexpr bool is_inline() const noexcept {
+        return N > 0 && m_data == m_inline.data();
+    }
+
+    friend void swap(basic_array_list& lhs, basic_array_list& rhs) noexcept {
+        if constexpr (N == 0) {
+            std::swap(lhs.m_data, rhs.m_data);
+            std::swap(lhs.m_size, rhs.m_size);
+            std::swap(lhs.m_capacity, rhs.m_capacity);
+            std::swap(lhs.m_alloc, rhs.m_alloc);
+        }
+        else {
+            auto tmp = static_cast<basic_array_list&&>(lhs);
+            lhs = static_cast<basic_array_list&&>(rhs);
+            rhs = static_cast<basic_array_list&&>(tmp);
+        }
+    }
+
+private:
+    size_type next_capacity(size_type needed) const noexcept {
+        auto grown = m_capacity + m_capacity / 2;
+        if (grown < k_min_capacity) {
+            grown = k_min_capacity;
+        }
+        return grown < needed ? needed : grown;
+    }
+
+    allocation_result<T*> allocate(size_type n) {
+        if constexpr (requires { m_alloc.allocate_at_least(n); }) {
+            return m_alloc.allocate_at_least(n);
+        }
+        else {
+            return { m_alloc.allocate(n), n };
+        }
+    }
+
+    // Move the elements into freshly allocated storage and free the old one.
+    void adopt(allocation_result<T*> storage) noexcept {
+        prelude::relocate(m_data, m_size, storage.ptr);
+        this->release();
+        m_data = storage.ptr;
+        m_capacity = storage.count;
+    }
+
+    void append_copy(T const* first, size_type n) {
+        for (size_type i = 0; i < n; ++i) {
+            ::new(m_data + m_size) T(first[i]);
+            ++m_size;
+        }
+    }
+
+    // Free the heap buffer, if any, and fall back to the inline one. The list must be empty.
+    void release() noexcept {
+        if (m_data != nullptr && !this->is_inline()) {
+            m_alloc.deallocate(m_data, m_capacity);
+        }
+        m_data = m_inline.data();
+        m_capacity = N;
+    }
+
+    // Take over the elements of other, which must be distinct, and leave it empty. Requires this
+    // list to be empty and on its inline buffer.
+    void steal(basic_array_list& other) noexcept {
+        m_alloc = static_cast<Alloc&&>(other.m_alloc);
+        if (other.is_inline()) {
+            prelude::relocate(other.m_data, other.m_size, m_data);
+            m_size = other.m_size;
+            other.m_size = 0;
+            return;
+        }
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_capacity = other.m_capacity;
+        other.m_data = other.m_inline.data();
+        other.m_size = 0;
+        other.m_capacity = N;
+    }
+
+    T* m_data;
+    size_type m_size = 0;
+    size_type m_capacity;
+    [[no_unique_address]] Alloc m_alloc = {};
+    [[no_unique_address]] inline_storage<T, N> m_inline;
 };
 
+template<typename T, typename Alloc = prelude::basic_allocator<T>>
+using array_list = basic_array_list<T, 0, Alloc>;
+
+/**
+ * @brief An array_list that keeps its first N elements inline and only moves to the heap once it
+ * overflows them; a good fit for short lists and for stack<T, small_array_list<T, 16>>.
+ */
+template<typename T, prelude::size_t N, typename Alloc = prelude::basic_allocator<T>>
+using small_array_list = basic_array_list<T, N, Alloc>;
+
 
 } // namespace prelude
\ No newline at end of file
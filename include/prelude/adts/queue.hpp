@@ -1,10 +1,20 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+
 #include "../defs.hpp"
+#include "../utils/allocator.hpp"
+#include "../utils/sync.hpp"
+#include "deque.hpp"
+#include "list.hpp"
 
 namespace prelude {
 
-template<typename T, typename Cont>
+template<typename T, typename Cont = prelude::deque<T>>
 class queue {
 public:
     using container_type = Cont;
@@ -15,7 +25,7 @@ public:
     using value_type = T;
 
     constexpr queue() noexcept(noexcept(container_type()))
-        : container_type() {}
+        : m_cont() {}
 
     constexpr queue(container_type const& cont)
         : m_cont(cont) {}
@@ -53,6 +63,10 @@ public:
         m_cont.push_back(val);
     }
 
+    constexpr void push(T&& val) {
+        m_cont.push_back(static_cast<T&&>(val));
+    }
+
 protected:
     constexpr iterator_type begin() const {
         return m_cont.begin();
@@ -66,5 +80,757 @@ private:
     container_type m_cont;
 };
 
+/**
+ * @brief Sift operations on an implicit D-ary heap stored in an array, where the children of slot i
+ * are slots D * i + 1 through D * i + D. Compared to a binary heap, a 4-ary heap is half as deep and
+ * its four children sit next to each other, usually in the same cache line, so a sift-down takes
+ * half as many cache misses for a few more comparisons that hit in cache.
+ *
+ * The sifts move a hole rather than swapping, and every element that lands in a slot goes through
+ * place(i, value), so a caller can track where each element lives.
+ */
+template<prelude::size_t D>
+struct d_ary_heap {
+    static_assert(D >= 2, "A heap needs at least two children per node");
+
+    using size_type = prelude::size_t;
+
+    static constexpr size_type parent(size_type i) noexcept {
+        return (i - 1) / D;
+    }
+
+    static constexpr size_type first_child(size_type i) noexcept {
+        return D * i + 1;
+    }
+
+    // Move value up from the hole at i until its parent is not less than it.
+    template<typename T>
+    static void sift_up(T* data, size_type i, T value, auto&& less, auto&& place) {
+        while (i > 0) {
+            auto const up = d_ary_heap::parent(i);
+            if (!less(data[up], value)) {
+                break;
+            }
+            place(i, static_cast<T&&>(data[up]));
+            i = up;
+        }
+        place(i, static_cast<T&&>(value));
+    }
+
+    // Move value down from the hole at i until none of its children is greater than it.
+    template<typename T>
+    static void sift_down(T* data, size_type n, size_type i, T value, auto&& less, auto&& place) {
+        while (true) {
+            auto const first = d_ary_heap::first_child(i);
+            if (first >= n) {
+                break;
+            }
+            auto const last = first + D < n ? first + D : n;
+            auto best = first;
+            for (auto child = first + 1; child < last; ++child) {
+                if (less(data[best], data[child])) {
+                    best = child;
+                }
+            }
+            if (!less(value, data[best])) {
+                break;
+            }
+            place(i, static_cast<T&&>(data[best]));
+            i = best;
+        }
+        place(i, static_cast<T&&>(value));
+    }
+
+    /**
+     * @brief Refill the hole at i with value, for when value most likely belongs near the bottom,
+     * as after moving the last element to the root on a pop. The hole first sinks all the way down
+     * along the greatest children without comparing against value, then value rises from there,
+     * which usually takes one comparison per level instead of two.
+     */
+    template<typename T>
+    static void sift_down_bottom_up(T* data, size_type n, size_type i, T value, auto&& less, auto&& place) {
+        auto const top = i;
+        while (true) {
+            auto const first = d_ary_heap::first_child(i);
+            if (first >= n) {
+                break;
+            }
+            auto const last = first + D < n ? first + D : n;
+            auto best = first;
+            for (auto child = first + 1; child < last; ++child) {
+                if (less(data[best], data[child])) {
+                    best = child;
+                }
+            }
+            place(i, static_cast<T&&>(data[best]));
+            i = best;
+        }
+        while (i > top) {
+            auto const up = d_ary_heap::parent(i);
+            if (!less(data[up], value)) {
+                break;
+            }
+            place(i, static_cast<T&&>(data[up]));
+            i = up;
+        }
+        place(i, static_cast<T&&>(value));
+    }
+
+    // Floyd's bottom-up construction: sift down every inner node, last first. O(n) overall.
+    template<typename T>
+    static void heapify(T* data, size_type n, auto&& less, auto&& place) {
+        if (n < 2) {
+            return;
+        }
+        for (auto i = d_ary_heap::parent(n - 1) + 1; i-- > 0;) {
+            d_ary_heap::sift_down(data, n, i, static_cast<T&&>(data[i]), less, place);
+        }
+    }
+};
+
+/**
+ * @brief A priority queue adapter over a contiguous container, kept as an implicit D-ary heap (4-ary
+ * by default; see d_ary_heap). top() is the greatest element under Compare.
+ *
+ * from_range builds the heap in O(n) instead of n pushes. push_pop and replace_top fuse a push and
+ * a pop into a single sift, which is the common step of top-k selection and of schedulers that
+ * requeue the task they just ran.
+ *
+ * @tparam T The element type.
+ * @tparam Cont The container, which must provide data(), size(), push_back() and pop_back().
+ * @tparam Compare The ordering; the greatest element is on top.
+ * @tparam D The number of children per node.
+ *
+ * @example Keeping the k smallest values.
+ * @code
+ *      auto heap = priority_queue<int>::from_range(values, values + k);
+ *      for (auto i = k; i < n; ++i) {
+ *          if (values[i] < heap.top()) {
+ *              heap.replace_top(values[i]);
+ *          }
+ *      }
+ * @endcode
+ */
+template<typename T, typename Cont = prelude::array_list<T>, typename Compare = std::less<T>, prelude::size_t D = 4>
+class priority_queue {
+public:
+    using container_type = Cont;
+    using heap_type = d_ary_heap<D>;
+    using pointer_type = T*;
+    using size_type = prelude::size_t;
+    using value_type = T;
+
+    constexpr priority_queue() noexcept(noexcept(container_type()))
+        : m_cont() {}
+
+    // Takes the elements of cont in any order and heapifies them.
+    priority_queue(container_type cont, Compare const& less = Compare())
+        : m_cont(static_cast<container_type&&>(cont)), m_less(less) {
+
+        heap_type::heapify(m_cont.data(), m_cont.size(), m_less, this->placer());
+    }
+
+    constexpr priority_queue(priority_queue const& other) = default;
+
+    constexpr priority_queue(priority_queue&& other) = default;
+
+    priority_queue& operator =(priority_queue const& other) = default;
+
+    priority_queue& operator =(priority_queue&& other) = default;
+
+    static priority_queue from_list(std::initializer_list<T> const& list) {
+        return priority_queue::from_range(list.begin(), list.end());
+    }
+
+    template<typename InIt>
+    static priority_queue from_range(InIt first, InIt last) {
+        return { container_type::from_range(first, last) };
+    }
+
+    constexpr bool empty() const noexcept {
+        return m_cont.size() == 0;
+    }
+
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        m_cont.push_back(T(static_cast<Args&&>(args)...));
+        this->restore_up();
+    }
+
+    constexpr bool is_empty() const noexcept {
+        return m_cont.size() == 0;
+    }
+
+    void pop() {
+        auto last = static_cast<T&&>(m_cont.data()[m_cont.size() - 1]);
+        m_cont.pop_back();
+        if (m_cont.size() != 0) {
+            heap_type::sift_down_bottom_up(m_cont.data(), m_cont.size(), 0, static_cast<T&&>(last), m_less, this->placer());
+        }
+    }
+
+    void push(T const& val) {
+        m_cont.push_back(val);
+        this->restore_up();
+    }
+
+    void push(T&& val) {
+        m_cont.push_back(static_cast<T&&>(val));
+        this->restore_up();
+    }
+
+    // Push val then pop the top, with at most one sift. Returns what was popped, which is val itself
+    // when nothing in the queue is greater.
+    T push_pop(T val) {
+        if (m_cont.size() == 0 || !m_less(val, this->top())) {
+            return val;
+        }
+        return this->replace_top(static_cast<T&&>(val));
+    }
+
+    // Pop the top then push val, with a single sift. The queue must not be empty.
+    T replace_top(T val) {
+        auto* data = m_cont.data();
+        auto result = static_cast<T&&>(data[0]);
+        heap_type::sift_down(data, m_cont.size(), 0, static_cast<T&&>(val), m_less, this->placer());
+        return result;
+    }
+
+    void reserve(size_type n) {
+        m_cont.reserve(n);
+    }
+
+    constexpr size_type size() const noexcept {
+        return m_cont.size();
+    }
+
+    constexpr T const& top() const {
+        return m_cont.data()[0];
+    }
+
+private:
+    auto placer() noexcept {
+        return [data = m_cont.data()](size_type i, T&& value) {
+            data[i] = static_cast<T&&>(value);
+        };
+    }
+
+    // The last element was just appended; move it up to its place.
+    void restore_up() {
+        auto* data = m_cont.data();
+        auto const i = m_cont.size() - 1;
+        heap_type::sift_up(data, i, static_cast<T&&>(data[i]), m_less, this->placer());
+    }
+
+    container_type m_cont;
+    [[no_unique_address]] Compare m_less = {};
+};
+
+/**
+ * @brief A D-ary heap priority queue whose elements can be re-prioritized in place. push returns a
+ * handle that stays valid until the element is popped or erased, and decrease_key moves an element
+ * towards the top (makes it greater under Compare) in O(log_D n), as Dijkstra and schedulers with
+ * aging need. Handles of removed elements are reused.
+ *
+ * @tparam T The element type.
+ * @tparam Compare The ordering; the greatest element is on top.
+ * @tparam D The number of children per node.
+ */
+template<typename T, typename Compare = std::less<T>, prelude::size_t D = 4>
+class indexed_priority_queue {
+public:
+    using heap_type = d_ary_heap<D>;
+    using size_type = prelude::size_t;
+    using value_type = T;
+    using handle_type = prelude::size_t;
+
+    static constexpr size_type k_npos = static_cast<size_type>(-1);
+
+    indexed_priority_queue() = default;
+
+    explicit indexed_priority_queue(Compare const& less)
+        : m_less { less } {}
+
+    bool contains(handle_type handle) const noexcept {
+        return handle < m_position.size() && m_position[handle] != k_npos;
+    }
+
+    /**
+     * @brief Give the element behind handle a new value that is not less than its current one, and
+     * move it up accordingly. Use update() when the value may move either way.
+     */
+    void decrease_key(handle_type handle, T value) {
+        auto const i = m_position[handle];
+        heap_type::sift_up(m_heap.data(), i, entry { static_cast<T&&>(value), handle }, m_less, this->placer());
+    }
+
+    constexpr bool empty() const noexcept {
+        return m_heap.size() == 0;
+    }
+
+    void erase(handle_type handle) {
+        this->remove_at(m_position[handle]);
+    }
+
+    constexpr bool is_empty() const noexcept {
+        return m_heap.size() == 0;
+    }
+
+    void pop() {
+        this->remove_at(0);
+    }
+
+    handle_type push(T value) {
+        handle_type handle;
+        if (m_free.size() != 0) {
+            handle = m_free.back();
+            m_free.pop_back();
+        }
+        else {
+            handle = m_position.size();
+            m_position.push_back(k_npos);
+        }
+        m_heap.push_back(entry { static_cast<T&&>(value), handle });
+        auto const i = m_heap.size() - 1;
+        heap_type::sift_up(m_heap.data(), i, static_cast<entry&&>(m_heap[i]), m_less, this->placer());
+        return handle;
+    }
+
+    constexpr size_type size() const noexcept {
+        return m_heap.size();
+    }
+
+    T const& top() const {
+        return m_heap[0].value;
+    }
+
+    handle_type top_handle() const {
+        return m_heap[0].handle;
+    }
+
+    // Give the element behind handle any new value and restore the heap.
+    void update(handle_type handle, T value) {
+        auto const i = m_position[handle];
+        if (m_less.less(m_heap[i].value, value)) {
+            this->decrease_key(handle, static_cast<T&&>(value));
+        }
+        else {
+            heap_type::sift_down(m_heap.data(), m_heap.size(), i, entry { static_cast<T&&>(value), handle }, m_less, this->placer());
+        }
+    }
+
+    T const& operator [](handle_type handle) const {
+        return m_heap[m_position[handle]].value;
+    }
+
+private:
+    struct entry {
+        T value;
+        handle_type handle;
+    };
+
+    struct entry_less {
+        [[no_unique_address]] Compare less;
+
+        bool operator ()(entry const& lhs, entry const& rhs) const {
+            return less(lhs.value, rhs.value);
+        }
+    };
+
+    auto placer() noexcept {
+        return [this](size_type i, entry&& value) {
+            m_position[value.handle] = i;
+            m_heap[i] = static_cast<entry&&>(value);
+        };
+    }
+
+    // Fill slot i with the last entry and let it settle in whichever direction it belongs.
+    void remove_at(size_type i) {
+        auto const handle = m_heap[i].handle;
+        m_position[handle] = k_npos;
+        m_free.push_back(handle);
+        auto last = static_cast<entry&&>(m_heap[m_heap.size() - 1]);
+        m_heap.pop_back();
+        if (i == m_heap.size()) {
+            return;
+        }
+        if (i > 0 && m_less(m_heap[heap_type::parent(i)], last)) {
+            heap_type::sift_up(m_heap.data(), i, static_cast<entry&&>(last), m_less, this->placer());
+        }
+        else {
+            heap_type::sift_down(m_heap.data(), m_heap.size(), i, static_cast<entry&&>(last), m_less, this->placer());
+        }
+    }
+
+    prelude::array_list<entry> m_heap;
+    // Slot of each handle in m_heap, or k_npos once it is removed.
+    prelude::array_list<size_type> m_position;
+    prelude::array_list<handle_type> m_free;
+    [[no_unique_address]] entry_less m_less = {};
+};
+
+/**
+ * @brief A bounded, lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * The head and tail indices live on separate cache lines, and each side keeps a private copy of the
+ * other side's index that it only refreshes when the queue looks full (or empty), so in steady state
+ * neither thread reads a line the other is writing. push_n and pop_n move a whole batch and publish
+ * it with a single release store.
+ *
+ * push, push_n are for the producer; top, pop, pop_n, try_pop and is_empty are for the consumer.
+ *
+ * @tparam T The element type.
+ * @tparam Alloc The allocator of the slot array.
+ */
+template<typename T, typename Alloc = prelude::basic_allocator<T>>
+class spsc_queue {
+public:
+    using value_type = T;
+    using size_type = prelude::size_t;
+    using allocator_type = Alloc;
+
+    // The capacity is rounded up to a power of two.
+    explicit spsc_queue(size_type capacity) {
+        auto rounded = size_type(1);
+        while (rounded < capacity) {
+            rounded *= 2;
+        }
+        m_mask = rounded - 1;
+        m_data = m_alloc.allocate(rounded);
+    }
+
+    spsc_queue(spsc_queue const&) = delete;
+
+    spsc_queue& operator =(spsc_queue const&) = delete;
+
+    ~spsc_queue() {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            auto const tail = m_producer.tail.load(std::memory_order_relaxed);
+            for (auto i = m_consumer.head.load(std::memory_order_relaxed); i != tail; ++i) {
+                m_data[i & m_mask].~T();
+            }
+        }
+        m_alloc.deallocate(m_data, m_mask + 1);
+    }
+
+    constexpr size_type capacity() const noexcept {
+        return m_mask + 1;
+    }
+
+    // Returns false if the queue is full.
+    bool push(T const& val) {
+        return this->emplace(val);
+    }
+
+    bool push(T&& val) {
+        return this->emplace(static_cast<T&&>(val));
+    }
+
+    template<typename... Args>
+    bool emplace(Args&&... args) {
+        auto const tail = m_producer.tail.load(std::memory_order_relaxed);
+        if (tail - m_producer.cached_head > m_mask) {
+            m_producer.cached_head = m_consumer.head.load(std::memory_order_acquire);
+            if (tail - m_producer.cached_head > m_mask) {
+                return false;
+            }
+        }
+        ::new(m_data + (tail & m_mask)) T(static_cast<Args&&>(args)...);
+        m_producer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Push up to n elements from first and publish them all at once.
+     *
+     * @return The number of elements pushed, which is less than n if the queue fills up.
+     */
+    template<typename InIt>
+    size_type push_n(InIt first, size_type n) {
+        auto const tail = m_producer.tail.load(std::memory_order_relaxed);
+        auto free = m_mask + 1 - (tail - m_producer.cached_head);
+        if (free < n) {
+            m_producer.cached_head = m_consumer.head.load(std::memory_order_acquire);
+            free = m_mask + 1 - (tail - m_producer.cached_head);
+        }
+        auto const count = free < n ? free : n;
+        for (size_type i = 0; i < count; ++i) {
+            ::new(m_data + ((tail + i) & m_mask)) T(*first);
+            ++first;
+        }
+        if (count != 0) {
+            m_producer.tail.store(tail + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    bool is_empty() noexcept {
+        auto const head = m_consumer.head.load(std::memory_order_relaxed);
+        if (head == m_consumer.cached_tail) {
+            m_consumer.cached_tail = m_producer.tail.load(std::memory_order_acquire);
+        }
+        return head == m_consumer.cached_tail;
+    }
+
+    // The oldest element. The queue must not be empty.
+    T& top() noexcept {
+        return m_data[m_consumer.head.load(std::memory_order_relaxed) & m_mask];
+    }
+
+    // Remove the oldest element. The queue must not be empty.
+    void pop() noexcept {
+        auto const head = m_consumer.head.load(std::memory_order_relaxed);
+        m_data[head & m_mask].~T();
+        m_consumer.head.store(head + 1, std::memory_order_release);
+    }
+
+    bool try_pop(T& out) {
+        if (this->is_empty()) {
+            return false;
+        }
+        out = static_cast<T&&>(this->top());
+        this->pop();
+        return true;
+    }
+
+    /**
+     * @brief Move up to n elements into out and release all their slots at once.
+     *
+     * @return The number of elements popped.
+     */
+    template<typename OutIt>
+    size_type pop_n(OutIt out, size_type n) {
+        auto const head = m_consumer.head.load(std::memory_order_relaxed);
+        auto available = m_consumer.cached_tail - head;
+        if (available < n) {
+            m_consumer.cached_tail = m_producer.tail.load(std::memory_order_acquire);
+            available = m_consumer.cached_tail - head;
+        }
+        auto const count = available < n ? available : n;
+        for (size_type i = 0; i < count; ++i) {
+            auto& slot = m_data[(head + i) & m_mask];
+            *out = static_cast<T&&>(slot);
+            ++out;
+            slot.~T();
+        }
+        if (count != 0) {
+            m_consumer.head.store(head + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+private:
+    // Written by the producer only.
+    struct alignas(k_cache_line_size) producer_side {
+        std::atomic<size_type> tail = 0;
+        size_type cached_head = 0;
+    };
+
+    // Written by the consumer only.
+    struct alignas(k_cache_line_size) consumer_side {
+        std::atomic<size_type> head = 0;
+        size_type cached_tail = 0;
+    };
+
+    producer_side m_producer;
+    consumer_side m_consumer;
+    alignas(k_cache_line_size) T* m_data = nullptr;
+    size_type m_mask = 0;
+    [[no_unique_address]] Alloc m_alloc = {};
+};
+
+/**
+ * @brief A bounded, lock-free queue for any number of producer and consumer threads, after Dmitry
+ * Vyukov's design. Every slot carries a sequence number that tells a producer whether the slot is
+ * free for its ticket and a consumer whether it holds the item for its ticket, so the only shared
+ * writes are one CAS on the enqueue or dequeue position per operation and no lock is ever taken.
+ *
+ * try_push and try_pop fail immediately when the queue is full or empty. push and pop block: they
+ * spin for k_spin_count attempts and then park the thread on an event counter, which the other
+ * side only bumps (and wakes) while someone is parked.
+ *
+ * @tparam T The element type.
+ */
+template<typename T>
+class mpmc_queue {
+public:
+    using value_type = T;
+    using size_type = prelude::size_t;
+
+    static constexpr size_type k_spin_count = 128;
+
+    // The capacity is rounded up to a power of two of at least 2.
+    explicit mpmc_queue(size_type capacity) {
+        auto rounded = size_type(2);
+        while (rounded < capacity) {
+            rounded *= 2;
+        }
+        m_mask = rounded - 1;
+        m_slots = slot_allocator().allocate(rounded);
+        for (size_type i = 0; i < rounded; ++i) {
+            ::new(m_slots + i) slot();
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpmc_queue(mpmc_queue const&) = delete;
+
+    mpmc_queue& operator =(mpmc_queue const&) = delete;
+
+    ~mpmc_queue() {
+        auto const tail = m_tail.position.load(std::memory_order_relaxed);
+        for (auto i = m_head.position.load(std::memory_order_relaxed); i != tail; ++i) {
+            m_slots[i & m_mask].data()->~T();
+        }
+        for (size_type i = 0; i <= m_mask; ++i) {
+            m_slots[i].~slot();
+        }
+        slot_allocator().deallocate(m_slots, m_mask + 1);
+    }
+
+    constexpr size_type capacity() const noexcept {
+        return m_mask + 1;
+    }
+
+    bool try_push(T const& val) {
+        return this->try_emplace(val);
+    }
+
+    bool try_push(T&& val) {
+        return this->try_emplace(static_cast<T&&>(val));
+    }
+
+    template<typename... Args>
+    bool try_emplace(Args&&... args) {
+        auto pos = m_tail.position.load(std::memory_order_relaxed);
+        while (true) {
+            auto& cell = m_slots[pos & m_mask];
+            auto const seq = cell.sequence.load(std::memory_order_acquire);
+            auto const diff = static_cast<prelude::ssize_t>(seq - pos);
+            if (diff == 0) {
+                if (m_tail.position.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    ::new(cell.data()) T(static_cast<Args&&>(args)...);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    this->signal(m_not_empty);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = m_tail.position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(T& out) {
+        auto pos = m_head.position.load(std::memory_order_relaxed);
+        while (true) {
+            auto& cell = m_slots[pos & m_mask];
+            auto const seq = cell.sequence.load(std::memory_order_acquire);
+            auto const diff = static_cast<prelude::ssize_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (m_head.position.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    auto* item = cell.data();
+                    out = static_cast<T&&>(*item);
+                    item->~T();
+                    cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    this->signal(m_not_full);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = m_head.position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void push(T const& val) {
+        this->block(m_not_full, [&] { return this->try_emplace(val); });
+    }
+
+    void push(T&& val) {
+        this->block(m_not_full, [&] { return this->try_emplace(static_cast<T&&>(val)); });
+    }
+
+    void pop(T& out) {
+        this->block(m_not_empty, [&] { return this->try_pop(out); });
+    }
+
+    T pop() {
+        auto result = T();
+        this->pop(result);
+        return result;
+    }
+
+    // A snapshot that may be stale by the time it returns.
+    bool is_empty() const noexcept {
+        return m_head.position.load(std::memory_order_relaxed) >= m_tail.position.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct slot {
+        std::atomic<size_type> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* data() noexcept {
+            return reinterpret_cast<T*>(storage);
+        }
+    };
+
+    using slot_allocator = prelude::basic_allocator<slot>;
+
+    struct alignas(k_cache_line_size) position_type {
+        std::atomic<size_type> position = 0;
+    };
+
+    // Threads parked waiting for one condition, and an event counter they sleep on. The counter is
+    // 32 bits wide so that waiting maps directly onto a futex where there is one.
+    struct alignas(k_cache_line_size) event_type {
+        std::atomic<unsigned> epoch = 0;
+        std::atomic<unsigned> sleepers = 0;
+    };
+
+    void signal(event_type& event) noexcept {
+        // Pairs with the fence in block(): either we see the sleeper, or it sees our item.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (event.sleepers.load(std::memory_order_relaxed) != 0) {
+            event.epoch.fetch_add(1, std::memory_order_release);
+            event.epoch.notify_all();
+        }
+    }
+
+    template<typename F>
+    void block(event_type& event, F&& attempt) {
+        for (size_type i = 0; i < k_spin_count; ++i) {
+            if (attempt()) {
+                return;
+            }
+            cpu_relax();
+        }
+        while (true) {
+            auto const epoch = event.epoch.load(std::memory_order_acquire);
+            event.sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (attempt()) {
+                event.sleepers.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+            event.epoch.wait(epoch, std::memory_order_acquire);
+            event.sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    position_type m_tail;
+    position_type m_head;
+    event_type m_not_empty;
+    event_type m_not_full;
+    alignas(k_cache_line_size) slot* m_slots = nullptr;
+    size_type m_mask = 0;
+};
 
-} // namespace prelude
\ No newline at end of file
+} // namespace prelude
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <new>
+#include <span>
+#include <utility>
+
+#include "../defs.hpp"
+#include "../structs/tuple.hpp"
+#include "../utils/allocator.hpp"
+#include "../utils/type_list.hpp"
+
+namespace prelude {
+
+template<typename List, bool Const>
+class soa_list_iterator;
+
+/**
+ * @brief A growable list of records stored as a structure of arrays: the i-th member of every
+ * record lives in the i-th column, a contiguous array of just that member type. A loop that reads
+ * one field only pulls that column through the cache, and column<I>() hands it out as a span for
+ * vectorized scans.
+ *
+ * All columns share one capacity and one allocation, each starting on its own cache line, so
+ * pushing, erasing and growing move every column together. Element access returns a tuple of
+ * references into the columns rather than a stored tuple.
+ *
+ * @tparam Ts The member types, one column each.
+ *
+ * @example
+ * @code
+ *      auto particles = soa_list<float, float, int>();
+ *      particles.push_back(1.0f, 2.0f, 7);
+ *      get<2>(particles[0]) = 8;
+ *      for (auto& x : particles.column<0>()) { x *= 2.0f; }
+ * @endcode
+ */
+template<typename... Ts>
+class soa_list {
+    static_assert(sizeof...(Ts) > 0, "soa_list needs at least one column");
+
+public:
+    using types = type_list<Ts...>;
+    using value_type = tuple<Ts...>;
+    using size_type = prelude::size_t;
+    using reference_type = tuple<Ts&...>;
+    using const_reference_type = tuple<Ts const&...>;
+    using iterator_type = soa_list_iterator<soa_list, false>;
+    using const_iterator_type = soa_list_iterator<soa_list, true>;
+
+    template<size_type I>
+    using column_type = typeof<type_nth<I, types>>;
+
+    static constexpr size_type k_columns = type_size<types>::value;
+    static constexpr size_type k_min_capacity = 4;
+
+    soa_list() noexcept = default;
+
+    // Delegating to the default constructor means the destructor cleans up the rows copied so
+    // far if copying a later one throws.
+    soa_list(soa_list const& other)
+        : soa_list() {
+
+        this->reserve(other.m_size);
+        for (size_type i = 0; i < other.m_size; ++i) {
+            [&]<size_type... I>(std::integer_sequence<size_type, I...>) {
+                soa_list::construct_at(m_columns, i, prelude::get<I>(other.m_columns)[i]...);
+            }(std::make_integer_sequence<size_type, k_columns>());
+            ++m_size;
+        }
+    }
+
+    soa_list(soa_list&& other) noexcept
+        : m_columns(static_cast<columns_type const&>(other.m_columns)), m_block(other.m_block), m_size(other.m_size), m_capacity(other.m_capacity) {
+
+        other.m_columns = columns_type(static_cast<Ts*>(nullptr)...);
+        other.m_block = nullptr;
+        other.m_size = 0;
+        other.m_capacity = 0;
+    }
+
+    ~soa_list() {
+        this->clear();
+        soa_list::deallocate(m_block, m_capacity);
+    }
+
+    soa_list& operator =(soa_list const& other) {
+        auto tmp = other;
+        swap(*this, tmp);
+        return *this;
+    }
+
+    soa_list& operator =(soa_list&& other) noexcept {
+        auto tmp = static_cast<soa_list&&>(other);
+        swap(*this, tmp);
+        return *this;
+    }
+
+    const_reference_type back() const {
+        return (*this)[m_size - 1];
+    }
+
+    reference_type back() {
+        return (*this)[m_size - 1];
+    }
+
+    const_iterator_type begin() const noexcept {
+        return { this, 0 };
+    }
+
+    iterator_type begin() noexcept {
+        return { this, 0 };
+    }
+
+    constexpr size_type capacity() const noexcept {
+        return m_capacity;
+    }
+
+    const_iterator_type cbegin() const noexcept {
+        return { this, 0 };
+    }
+
+    const_iterator_type cend() const noexcept {
+        return { this, m_size };
+    }
+
+    void clear() noexcept {
+        soa_list::for_each_column([&]<size_type I>() {
+            auto* column = prelude::get<I>(m_columns);
+            prelude::destroy(column, column + m_size);
+        });
+        m_size = 0;
+    }
+
+    // The I-th member of every element, contiguous.
+    template<size_type I>
+    std::span<column_type<I> const> column() const noexcept {
+        return { prelude::get<I>(m_columns), m_size };
+    }
+
+    template<size_type I>
+    std::span<column_type<I>> column() noexcept {
+        return { prelude::get<I>(m_columns), m_size };
+    }
+
+    template<typename... Args>
+    reference_type emplace_back(Args&&... args) requires (sizeof...(Args) == k_columns) {
+        if (m_size == m_capacity) {
+            // The arguments may refer into the list, so construct into the new storage first.
+            auto const grown = this->next_capacity(m_size + 1);
+            auto* block = soa_list::allocate(grown);
+            // Frees the new block again if constructing the element throws.
+            struct release_block {
+                unsigned char*& block;
+                size_type capacity;
+
+                ~release_block() {
+                    soa_list::deallocate(block, capacity);
+                }
+            } guard { block, grown };
+            auto columns = soa_list::columns_of(block, grown);
+            soa_list::construct_at(columns, m_size, static_cast<Args&&>(args)...);
+            this->adopt(block, columns, grown);
+            block = nullptr;
+        }
+        else {
+            soa_list::construct_at(m_columns, m_size, static_cast<Args&&>(args)...);
+        }
+        return (*this)[m_size++];
+    }
+
+    constexpr bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    const_iterator_type end() const noexcept {
+        return { this, m_size };
+    }
+
+    iterator_type end() noexcept {
+        return { this, m_size };
+    }
+
+    // Remove the element at index i, shifting the later ones down in every column.
+    void erase(size_type i) {
+        this->erase(i, i + 1);
+    }
+
+    void erase(size_type first, size_type last) {
+        soa_list::for_each_column([&]<size_type I>() {
+            auto* column = prelude::get<I>(m_columns);
+            prelude::destroy(column + first, column + last);
+            prelude::relocate(column + last, m_size - last, column + first);
+        });
+        m_size -= last - first;
+    }
+
+    const_reference_type front() const {
+        return (*this)[0];
+    }
+
+    reference_type front() {
+        return (*this)[0];
+    }
+
+    constexpr bool is_empty() const noexcept {
+        return m_size == 0;
+    }
+
+    void pop_back() {
+        --m_size;
+        soa_list::for_each_column([&]<size_type I>() {
+            auto* last = prelude::get<I>(m_columns) + m_size;
+            prelude::destroy(last, last + 1);
+        });
+    }
+
+    void push_back(Ts const&... values) {
+        this->emplace_back(values...);
+    }
+
+    void push_back(Ts&&... values) {
+        this->emplace_back(static_cast<Ts&&>(values)...);
+    }
+
+    void push_back(value_type const& value) {
+        [&]<size_type... I>(std::integer_sequence<size_type, I...>) {
+            this->emplace_back(prelude::get<I>(value)...);
+        }(std::make_integer_sequence<size_type, k_columns>());
+    }
+
+    void reserve(size_type n) {
+        if (n > m_capacity) {
+            auto* block = soa_list::allocate(n);
+            this->adopt(block, soa_list::columns_of(block, n), n);
+        }
+    }
+
+    constexpr size_type size() const noexcept {
+        return m_size;
+    }
+
+    // Element i as a tuple of references into the columns.
+    const_reference_type operator [](size_type i) const {
+        return [&]<size_type... I>(std::integer_sequence<size_type, I...>) {
+            return const_reference_type(prelude::get<I>(m_columns)[i]...);
+        }(std::make_integer_sequence<size_type, k_columns>());
+    }
+
+    reference_type operator [](size_type i) {
+        return [&]<size_type... I>(std::integer_sequence<size_type, I...>) {
+            return reference_type(prelude::get<I>(m_columns)[i]...);
+        }(std::make_integer_sequence<size_type, k_columns>());
+    }
+
+    friend void swap(soa_list& lhs, soa_list& rhs) noexcept {
+        std::swap(lhs.m_columns, rhs.m_columns);
+        std::swap(lhs.m_block, rhs.m_block);
+        std::swap(lhs.m_size, rhs.m_size);
+        std::swap(lhs.m_capacity, rhs.m_capacity);
+    }
+
+private:
+    using columns_type = tuple<Ts*...>;
+
+    static void for_each_column(auto&& f) {
+        [&]<size_type... I>(std::integer_sequence<size_type, I...>) {
+            (f.template operator()<I>(), ...);
+        }(std::make_integer_sequence<size_type, k_columns>());
+    }
+
+    // Column I starts at the first cache line past the columns before it.
+    static constexpr size_type column_bytes(size_type bytes) noexcept {
+        return (bytes + k_cache_line_size - 1) / k_cache_line_size * k_cache_line_size;
+    }
+
+    static constexpr size_type block_size(size_type capacity) noexcept {
+        return (soa_list::column_bytes(capacity * sizeof(Ts)) + ...);
+    }
+
+    static unsigned char* allocate(size_type capacity) {
+        return static_cast<unsigned char*>(
+            ::operator new(soa_list::block_size(capacity), std::align_val_t(k_cache_line_size)));
+    }
+
+    static void deallocate(unsigned char* block, size_type capacity) noexcept {
+        if (block != nullptr) {
+            ::operator delete(block, soa_list::block_size(capacity), std::align_val_t(k_cache_line_size));
+        }
+    }
+
+    static columns_type columns_of(unsigned char* block, size_type capacity) noexcept {
+        auto offset = 0uz;
+        auto const next = [&]<typename T>() {
+            auto* column = reinterpret_cast<T*>(block + offset);
+            offset += soa_list::column_bytes(capacity * sizeof(T));
+            return column;
+        };
+        // Braced initialization evaluates left to right, so the columns are laid out in order.
+        return columns_type { next.template operator()<Ts>()... };
+    }
+
+    // Build element i column by column. If a column's constructor throws, the columns already
+    // built for i are destroyed before the exception leaves.
+    template<typename... Args>
+    static void construct_at(columns_type& columns, size_type i, Args&&... args) {
+        struct rollback {
+            columns_type& columns;
+            size_type i;
+            size_type built = 0;
+
+            ~rollback() {
+                soa_list::for_each_column([&]<size_type I>() {
+                    if (I < built && built < k_columns) {
+                        prelude::destroy(prelude::get<I>(columns) + i, prelude::get<I>(columns) + i + 1);
+                    }
+                });
+            }
+        } guard { columns, i };
+        [&]<size_type... I>(std::integer_sequence<size_type, I...>) {
+            ((::new(prelude::get<I>(columns) + i) column_type<I>(static_cast<Args&&>(args)), ++guard.built), ...);
+        }(std::make_integer_sequence<size_type, k_columns>());
+    }
+
+    // Move every column into a freshly allocated block and free the old one.
+    void adopt(unsigned char* block, columns_type columns, size_type capacity) noexcept {
+        soa_list::for_each_column([&]<size_type I>() {
+            prelude::relocate(prelude::get<I>(m_columns), m_size, prelude::get<I>(columns));
+        });
+        soa_list::deallocate(m_block, m_capacity);
+        m_columns = columns;
+        m_block = block;
+        m_capacity = capacity;
+    }
+
+    size_type next_capacity(size_type needed) const noexcept {
+        auto grown = m_capacity + m_capacity / 2;
+        if (grown < k_min_capacity) {
+            grown = k_min_capacity;
+        }
+        return grown < needed ? needed : grown;
+    }
+
+    columns_type m_columns = columns_type(static_cast<Ts*>(nullptr)...);
+    unsigned char* m_block = nullptr;
+    size_type m_size = 0;
+    size_type m_capacity = 0;
+};
+
+template<typename List, bool Const>
+class soa_list_iterator {
+public:
+    using container_type = std::conditional_t<Const, List const, List>;
+    using value_type = List::value_type;
+    using size_type = prelude::size_t;
+    using difference_type = prelude::ssize_t;
+    using reference_type = std::conditional_t<Const, typename List::const_reference_type, typename List::reference_type>;
+    using const_reference_type = List::const_reference_type;
+
+    constexpr soa_list_iterator() noexcept = default;
+
+    constexpr soa_list_iterator(container_type* list, size_type index) noexcept
+        : m_list(list), m_index(index) {}
+
+    // Dereferencing yields a proxy by value; bind it with auto or auto&&, not auto&.
+    reference_type operator *() const {
+        return (*m_list)[m_index];
+    }
+
+    soa_list_iterator& operator ++() noexcept {
+        ++m_index;
+        return *this;
+    }
+
+    soa_list_iterator operator ++(int) noexcept {
+        auto ret = *this;
+        ++m_index;
+        return ret;
+    }
+
+    constexpr bool operator ==(soa_list_iterator const& other) const noexcept {
+        return m_index == other.m_index;
+    }
+
+private:
+    container_type* m_list = nullptr;
+    size_type m_index = 0;
+};
+
+} // namespace prelude
@@ -1,10 +1,18 @@
 #pragma once
 
+#include <atomic>
+#include <initializer_list>
+
 #include "../defs.hpp"
+#include "../structs/linked.hpp"
+#include "../utils/allocator.hpp"
+#include "../utils/epoch.hpp"
+#include "../utils/sync.hpp"
+#include "list.hpp"
 
 namespace prelude {
 
-template<typename T, typename Cont>
+template<typename T, typename Cont = prelude::array_list<T>>
 class stack {
 public:
     using container_type = Cont;
@@ -15,7 +23,7 @@ public:
     using value_type = T;
 
     constexpr stack() noexcept(noexcept(container_type()))
-        : container_type() {}
+        : m_cont() {}
 
     constexpr stack(container_type const& cont)
         : m_cont(cont) {}
@@ -70,4 +78,192 @@ private:
     container_type m_cont;
 };
 
-} // namespace prelude
\ No newline at end of file
+/**
+ * @brief A lock-free (Treiber) stack of singly_linked_node<T>, safe to push to and pop from on any
+ * number of threads.
+ *
+ * The head is a tagged pointer: the upper bits of the word count every successful update, so a
+ * node that is popped, recycled and pushed again between a thread's read and its CAS never fools
+ * that CAS (the ABA problem). A thread that lost a race may still read the next pointer of a node
+ * another thread has already popped, so popping pins the epoch (epoch_guard) and popped nodes are
+ * freed through epoch_domain::retire_node, never directly, while other threads may be popping.
+ *
+ * Under contention a failed CAS does not simply retry: the thread visits a random slot of an
+ * elimination array, where a push and a pop that meet exchange the node directly and both finish
+ * without touching the head. Failed eliminations back off exponentially.
+ *
+ * @tparam T The element type.
+ */
+template<typename T>
+class concurrent_stack {
+public:
+    using value_type = T;
+    using node_type = singly_linked_node<T>;
+    using allocator_type = prelude::node_allocator<node_type>;
+    using size_type = prelude::size_t;
+
+    static constexpr size_type k_elimination_size = 8;
+    static constexpr size_type k_elimination_spins = 64;
+    static constexpr size_type k_max_backoff = 1024;
+
+    constexpr concurrent_stack() noexcept = default;
+
+    concurrent_stack(concurrent_stack const&) = delete;
+
+    concurrent_stack& operator =(concurrent_stack const&) = delete;
+
+    // No other thread can be using the stack by now, so nodes go straight back to the allocator.
+    ~concurrent_stack() {
+        while (auto* node = this->pop_node()) {
+            node->~node_type();
+            m_alloc.deallocate(node, 1);
+        }
+    }
+
+    void push(T const& val) {
+        this->push_node(m_alloc.new_object(val, nullptr));
+    }
+
+    void push(T&& val) {
+        this->push_node(m_alloc.new_object(static_cast<T&&>(val), nullptr));
+    }
+
+    bool try_pop(T& out) {
+        auto guard = epoch_guard();
+        auto* node = this->pop_node();
+        if (node == nullptr) {
+            return false;
+        }
+        out = static_cast<T&&>(node->data);
+        epoch_domain::retire_node<node_type, allocator_type>(node);
+        return true;
+    }
+
+    // Push a node the caller owns. The stack owns it until it is popped again.
+    void push_node(node_type* node) noexcept {
+        auto backoff = size_type(1);
+        auto head = m_head.load(std::memory_order_relaxed);
+        while (true) {
+            concurrent_stack::store_next(node, concurrent_stack::pointer(head));
+            if (m_head.compare_exchange_weak(head, concurrent_stack::pack(node, head), std::memory_order_release, std::memory_order_relaxed)) {
+                return;
+            }
+            if (this->offer(node)) {
+                return;
+            }
+            concurrent_stack::pause(backoff);
+            head = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Pop a node, handing its ownership to the caller. Returns nullptr when the stack is empty.
+    // Other threads may still be reading the node, so free it through epoch_domain::retire_node.
+    node_type* pop_node() {
+        auto guard = epoch_guard();
+        auto backoff = size_type(1);
+        auto head = m_head.load(std::memory_order_acquire);
+        while (true) {
+            auto* node = concurrent_stack::pointer(head);
+            if (node == nullptr) {
+                return nullptr;
+            }
+            // The node may already have been popped by another thread, and even pushed again; the
+            // pin keeps it from being freed under us, and the tag makes the CAS fail.
+            auto* next = concurrent_stack::load_next(node);
+            if (m_head.compare_exchange_weak(head, concurrent_stack::pack(next, head), std::memory_order_acquire, std::memory_order_acquire)) {
+                return node;
+            }
+            if (auto* taken = this->take()) {
+                return taken;
+            }
+            concurrent_stack::pause(backoff);
+            head = m_head.load(std::memory_order_acquire);
+        }
+    }
+
+    // A snapshot that may be stale by the time it returns.
+    bool is_empty() const noexcept {
+        return concurrent_stack::pointer(m_head.load(std::memory_order_relaxed)) == nullptr;
+    }
+
+private:
+    using word_type = unsigned long long;
+
+    // On 64-bit targets user-space addresses fit in the low 48 bits; on 32-bit targets the tag gets
+    // the whole upper half of the word.
+    static constexpr word_type k_pointer_bits = sizeof(void*) == 8 ? 48 : 32;
+    static constexpr word_type k_pointer_mask = (word_type(1) << k_pointer_bits) - 1;
+
+    static node_type* pointer(word_type word) noexcept {
+        return reinterpret_cast<node_type*>(static_cast<prelude::size_t>(word & k_pointer_mask));
+    }
+
+    // Tag the new head with one more than the tag of the head it replaces.
+    static word_type pack(node_type* node, word_type previous) noexcept {
+        auto const tag = (previous >> k_pointer_bits) + 1;
+        return (tag << k_pointer_bits) | (reinterpret_cast<prelude::size_t>(node) & k_pointer_mask);
+    }
+
+    // A recycled node's next is rewritten by push_node while a stale popper may still read it.
+    static node_type* load_next(node_type* node) noexcept {
+        return std::atomic_ref(node->next).load(std::memory_order_relaxed);
+    }
+
+    static void store_next(node_type* node, node_type* next) noexcept {
+        std::atomic_ref(node->next).store(next, std::memory_order_relaxed);
+    }
+
+    static void pause(size_type& backoff) noexcept {
+        for (size_type i = 0; i < backoff; ++i) {
+            cpu_relax();
+        }
+        if (backoff < k_max_backoff) {
+            backoff *= 2;
+        }
+    }
+
+    static size_type random_slot() noexcept {
+        thread_local auto state = static_cast<unsigned>(reinterpret_cast<prelude::size_t>(&state) >> 4) | 1u;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state % k_elimination_size;
+    }
+
+    // Leave the node in an elimination slot for a while. Returns true if a popper took it.
+    bool offer(node_type* node) noexcept {
+        auto& slot = m_elimination[concurrent_stack::random_slot()].node;
+        node_type* expected = nullptr;
+        if (!slot.compare_exchange_strong(expected, node, std::memory_order_release, std::memory_order_relaxed)) {
+            return false;
+        }
+        for (size_type i = 0; i < k_elimination_spins; ++i) {
+            if (slot.load(std::memory_order_relaxed) != node) {
+                return true;
+            }
+            cpu_relax();
+        }
+        expected = node;
+        return !slot.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed, std::memory_order_relaxed);
+    }
+
+    // Take a node a pusher is offering, if there is one in the slot we visit.
+    node_type* take() noexcept {
+        auto& slot = m_elimination[concurrent_stack::random_slot()].node;
+        auto* node = slot.load(std::memory_order_acquire);
+        if (node != nullptr && slot.compare_exchange_strong(node, nullptr, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return node;
+        }
+        return nullptr;
+    }
+
+    struct alignas(k_cache_line_size) exchanger {
+        std::atomic<node_type*> node = nullptr;
+    };
+
+    alignas(k_cache_line_size) std::atomic<word_type> m_head = 0;
+    exchanger m_elimination[k_elimination_size];
+    [[no_unique_address]] allocator_type m_alloc = {};
+};
+
+} // namespace prelude
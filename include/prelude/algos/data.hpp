@@ -18,7 +18,7 @@ inline void fill(OutIt first, OutIt last, T const& val) {
 
 template<typename OutIt, typename... Args>
 inline void fill_args(OutIt first, Args&&... args) {
-    (*first++ = static_cast<Args&&>(args), ...);
+    ((*first++ = static_cast<Args&&>(args)), ...);
 }
 
 inline void fill_zeros(void* first, void* last) {
@@ -30,7 +30,7 @@ inline void fill_zeros(void* first, void* last) {
 
 template<typename T>
 inline void overwrite_with_zeros(T& t) {
-    void* ptr = static_cast<void*>(&t);
+    auto* ptr = reinterpret_cast<unsigned char*>(&t);
     prelude::fill_zeros(ptr, ptr + sizeof(T));
 }
 
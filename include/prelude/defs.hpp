@@ -14,24 +14,40 @@
 #define LINUX 1
 #endif
 
+#if WINDOWS
+#include <malloc.h>
+#else
+#include <alloca.h>
+#endif
+
+// Stack allocation
+// Room for n objects of type T in the calling frame, released when that frame returns. This has to
+// be a macro: alloca inside a function, even a forced-inline one, may be released when that call
+// ends, leaving the caller with a dangling pointer.
+#if WINDOWS
+#define PRELUDE_STACKALLOC(T, n) (static_cast<T*>(_alloca((n) * sizeof(T))))
+#else
+#define PRELUDE_STACKALLOC(T, n) (static_cast<T*>(alloca((n) * sizeof(T))))
+#endif
+
 namespace prelude {
 
 
 using size_t = unsigned long long;
 using ssize_t = long long;
 
+// The unit of coherence between cores. Data written by different threads should not share one.
+inline constexpr size_t k_cache_line_size = 64;
 
-// Stack allocation
-#if WINDOWS
-template<typename T>
-T* stackalloc(size_t n) {
-    return static_cast<T*>(_malloca(n * sizeof(T)));
-}
-#elif OSX || LINUX
-template<typename T>
-T* stackalloc(size_t n) {
-    return static_cast<T*>(alloca(n * sizeof(T)));
-}
+
+// Ask for the cache line holding ptr ahead of a read. This is only a hint: it never faults, even
+// for addresses past the end of an object.
+inline void prefetch(void const* ptr) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr);
+#else
+    (void)ptr;
 #endif
+}
 
 } // namespace prelude
@@ -100,19 +100,20 @@ constexpr array<T, N + M> concat(array<T, N> const& arr, array<T, M> const& brr)
 }
 
 // Support for structured bindings
-template<typename T, prelude::size_t N>
-struct std::tuple_size<array<T, N>> : std::integral_constant<prelude::size_t, N> {};
-
 template<prelude::size_t I, typename T, prelude::size_t N>
-struct std::tuple_element<I, array<T, N>> {
+constexpr T& get(array<T, N>& arr) {
     static_assert(I < N, "Index out of bound");
-    using type = T;
-};
-
-template<prelude::size_t I, typename T, prelude::size_t N>
-constexpr std::tuple_element_t<I, array<T, N>>& get(array<T, N>& arr) {
     return arr[I];
 }
 
+} // namespace prelude
 
-} // namespace prelude
\ No newline at end of file
+// The std specializations have to live outside prelude and be keyed on std::size_t.
+template<typename T, prelude::size_t N>
+struct std::tuple_size<prelude::array<T, N>> : std::integral_constant<std::size_t, N> {};
+
+template<std::size_t I, typename T, prelude::size_t N>
+struct std::tuple_element<I, prelude::array<T, N>> {
+    static_assert(I < N, "Index out of bound");
+    using type = T;
+};
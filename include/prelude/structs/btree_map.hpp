@@ -0,0 +1,597 @@
+#pragma once
+
+#include <bit>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#include "../defs.hpp"
+#include "../utils/allocator.hpp"
+#include "linked.hpp"
+
+namespace prelude {
+
+// The bytes a B+tree node is sized to: a few cache lines, read with one or two prefetched misses.
+// Nodes are also aligned to a cache line, so a node never touches more lines than it fills.
+inline constexpr prelude::size_t k_btree_node_size = 4 * k_cache_line_size;
+
+// Children per inner node so that tree_node<btree_keys<K, N>, N> fits in k_btree_node_size.
+template<typename K>
+inline constexpr prelude::size_t k_btree_fanout =
+    (k_btree_node_size - sizeof(prelude::size_t) + sizeof(K)) / (sizeof(K) + sizeof(void*));
+
+// Entries per leaf so that a btree_leaf fits in k_btree_node_size, but at least 4.
+template<typename K, typename V>
+inline constexpr prelude::size_t k_btree_leaf_capacity =
+    (k_btree_node_size - 2 * sizeof(void*)) / (sizeof(K) + sizeof(V)) < 4
+        ? 4
+        : (k_btree_node_size - 2 * sizeof(void*)) / (sizeof(K) + sizeof(V));
+
+/**
+ * @brief How many of the n sorted keys are less than key, or with Inclusive, not greater than it.
+ * Signed 32-bit keys are compared four at a time with SSE2 and signed 64-bit keys two at a time
+ * with SSE4.2; everything else takes a branch-free scalar loop that the compiler may vectorize.
+ */
+template<bool Inclusive, typename K>
+inline prelude::size_t btree_rank(K const* keys, prelude::size_t n, K const& key) noexcept {
+    prelude::size_t i = 0;
+    prelude::size_t result = 0;
+#if defined(__SSE2__)
+    if constexpr (std::is_integral_v<K> && std::is_signed_v<K> && sizeof(K) == 4) {
+        auto const needle = _mm_set1_epi32(static_cast<int>(key));
+        for (; i + 4 <= n; i += 4) {
+            auto const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + i));
+            // The inclusive count is taken as the complement of the keys that are greater.
+            auto const mask = Inclusive ? _mm_cmpgt_epi32(block, needle) : _mm_cmpgt_epi32(needle, block);
+            auto const hits = std::popcount(static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(mask))));
+            result += Inclusive ? 4 - hits : hits;
+        }
+    }
+#endif
+#if defined(__SSE4_2__)
+    if constexpr (std::is_integral_v<K> && std::is_signed_v<K> && sizeof(K) == 8) {
+        auto const needle = _mm_set1_epi64x(static_cast<long long>(key));
+        for (; i + 2 <= n; i += 2) {
+            auto const block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(keys + i));
+            auto const mask = Inclusive ? _mm_cmpgt_epi64(block, needle) : _mm_cmpgt_epi64(needle, block);
+            auto const hits = std::popcount(static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(mask))));
+            result += Inclusive ? 2 - hits : hits;
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        result += Inclusive ? !(key < keys[i]) : keys[i] < key;
+    }
+    return result;
+}
+
+// The payload of an inner node: count children, separated by count - 1 keys. Child i holds the
+// keys in [keys[i - 1], keys[i]).
+template<typename K, prelude::size_t N>
+struct btree_keys {
+    prelude::size_t count;
+    K keys[N - 1];
+};
+
+template<typename K, typename V, prelude::size_t L>
+struct alignas(k_cache_line_size) btree_leaf {
+    prelude::size_t count;
+    btree_leaf* next;
+    K keys[L];
+    V values[L];
+};
+
+// What a btree_map iterator points at. Keys and values live in separate arrays, so this is a pair
+// of references rather than a stored pair.
+template<typename K, typename V>
+struct btree_entry {
+    K const& key;
+    V& value;
+};
+
+template<typename Map, bool Const>
+class btree_iterator;
+
+/**
+ * @brief An ordered map as a B+tree whose nodes are sized to a few cache lines. Inner nodes are
+ * tree_node<btree_keys<K, N>, N>, holding separator keys and N children; leaves hold the keys and
+ * values in separate arrays, so searching a node scans one dense key array, with SIMD for integer
+ * keys. Leaves are chained for range scans, and a sorted input can be bulk-loaded into full leaves
+ * without any splitting.
+ *
+ * Keys are compared with operator <. Keys and values must be default-constructible, since nodes
+ * keep them in plain arrays. erase does not rebalance: nodes may end up underfull, which only
+ * costs space until the map is rebuilt.
+ *
+ * @tparam K The key type.
+ * @tparam V The mapped type.
+ * @tparam N The fan-out of inner nodes.
+ * @tparam L The capacity of leaves.
+ *
+ * @example
+ * @code
+ *      auto map = btree_map<int, float>::from_sorted_range(pairs.begin(), pairs.end());
+ *      for (auto it = map.lower_bound(lo); it != map.end() && (*it).key < hi; ++it) { ... }
+ * @endcode
+ */
+template<typename K, typename V, prelude::size_t N = k_btree_fanout<K>, prelude::size_t L = k_btree_leaf_capacity<K, V>>
+class btree_map {
+public:
+    static_assert(N >= 3 && L >= 2, "btree_map nodes are too small to split");
+
+    using key_type = K;
+    using mapped_type = V;
+    using size_type = prelude::size_t;
+    using inner_type = tree_node<btree_keys<K, N>, N>;
+    using leaf_type = btree_leaf<K, V, L>;
+    using reference_type = btree_entry<K, V>;
+    using const_reference_type = btree_entry<K, V const>;
+    using iterator_type = btree_iterator<btree_map, false>;
+    using const_iterator_type = btree_iterator<btree_map, true>;
+
+    static constexpr size_type k_max_height = 32;
+
+    btree_map() noexcept = default;
+
+    btree_map(btree_map const& other)
+        : btree_map(btree_map::from_sorted_range(other.begin(), other.end())) {}
+
+    btree_map(btree_map&& other) noexcept
+        : m_root(other.m_root), m_first(other.m_first), m_height(other.m_height), m_size(other.m_size) {
+
+        other.m_root = nullptr;
+        other.m_first = nullptr;
+        other.m_height = 0;
+        other.m_size = 0;
+    }
+
+    ~btree_map() {
+        this->clear();
+    }
+
+    btree_map& operator =(btree_map const& other) {
+        if (this != &other) {
+            auto tmp = other;
+            swap(*this, tmp);
+        }
+        return *this;
+    }
+
+    btree_map& operator =(btree_map&& other) noexcept {
+        auto tmp = static_cast<btree_map&&>(other);
+        swap(*this, tmp);
+        return *this;
+    }
+
+    /**
+     * @brief Build a map from entries sorted by strictly increasing key, each destructurable into a
+     * key and a value. Leaves are filled completely and the inner levels are built bottom-up, in
+     * linear time and with no splits.
+     */
+    template<typename InIt>
+    static btree_map from_sorted_range(InIt first, InIt last) {
+        auto result = btree_map();
+        auto leaf_alloc = prelude::node_allocator<leaf_type>();
+        leaf_type* leaf = nullptr;
+        size_type leaves = 0;
+        while (first != last) {
+            auto&& [key, value] = *first;
+            if (leaf == nullptr || leaf->count == L) {
+                auto* fresh = ::new(leaf_alloc.allocate(1)) leaf_type();
+                (leaf == nullptr ? result.m_first : leaf->next) = fresh;
+                leaf = fresh;
+                ++leaves;
+            }
+            leaf->keys[leaf->count] = key;
+            leaf->values[leaf->count] = value;
+            ++leaf->count;
+            ++result.m_size;
+            ++first;
+        }
+        if (leaves == 0) {
+            return result;
+        }
+
+        // Each level is a list of nodes with the smallest key below each of them.
+        auto node_alloc = prelude::basic_allocator<void*>();
+        auto key_alloc = prelude::basic_allocator<K>();
+        auto* nodes = node_alloc.allocate(leaves);
+        auto* mins = key_alloc.allocate(leaves);
+        auto* it = result.m_first;
+        for (size_type i = 0; i < leaves; ++i, it = it->next) {
+            nodes[i] = it;
+            ::new(mins + i) K(it->keys[0]);
+        }
+        auto width = leaves;
+        while (width > 1) {
+            auto const parents = (width + N - 1) / N;
+            for (size_type p = 0; p < parents; ++p) {
+                auto* inner = result.make_inner();
+                auto const begin = p * N;
+                auto const end = begin + N < width ? begin + N : width;
+                for (auto c = begin; c < end; ++c) {
+                    inner->children[c - begin] = static_cast<inner_type*>(nodes[c]);
+                    if (c > begin) {
+                        inner->data.keys[c - begin - 1] = mins[c];
+                    }
+                }
+                inner->data.count = end - begin;
+                nodes[p] = inner;
+                mins[p] = mins[begin];
+            }
+            width = parents;
+            ++result.m_height;
+        }
+        result.m_root = nodes[0];
+        prelude::destroy(mins, mins + leaves);
+        key_alloc.deallocate(mins, leaves);
+        node_alloc.deallocate(nodes, leaves);
+        return result;
+    }
+
+    const_iterator_type begin() const noexcept {
+        return const_iterator_type(m_first, 0).skip_empty();
+    }
+
+    iterator_type begin() noexcept {
+        return iterator_type(m_first, 0).skip_empty();
+    }
+
+    const_iterator_type cbegin() const noexcept {
+        return this->begin();
+    }
+
+    constexpr const_iterator_type cend() const noexcept {
+        return {};
+    }
+
+    void clear() noexcept {
+        if (m_root != nullptr) {
+            this->destroy(m_root, m_height);
+        }
+        m_root = nullptr;
+        m_first = nullptr;
+        m_height = 0;
+        m_size = 0;
+    }
+
+    bool contains(K const& key) const {
+        return this->find(key) != nullptr;
+    }
+
+    constexpr bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    constexpr const_iterator_type end() const noexcept {
+        return {};
+    }
+
+    constexpr iterator_type end() noexcept {
+        return {};
+    }
+
+    // Remove key; returns whether it was there. Leaves are not merged afterwards.
+    bool erase(K const& key) {
+        if (m_root == nullptr) {
+            return false;
+        }
+        auto* leaf = this->find_leaf(key);
+        auto const i = prelude::btree_rank<false>(leaf->keys, leaf->count, key);
+        if (i == leaf->count || key < leaf->keys[i]) {
+            return false;
+        }
+        for (auto j = i + 1; j < leaf->count; ++j) {
+            leaf->keys[j - 1] = static_cast<K&&>(leaf->keys[j]);
+            leaf->values[j - 1] = static_cast<V&&>(leaf->values[j]);
+        }
+        --leaf->count;
+        --m_size;
+        return true;
+    }
+
+    V const* find(K const& key) const {
+        return const_cast<btree_map*>(this)->find(key);
+    }
+
+    V* find(K const& key) {
+        if (m_root == nullptr) {
+            return nullptr;
+        }
+        auto* leaf = this->find_leaf(key);
+        auto const i = prelude::btree_rank<false>(leaf->keys, leaf->count, key);
+        return i < leaf->count && !(key < leaf->keys[i]) ? leaf->values + i : nullptr;
+    }
+
+    // Insert key unless it is already present; returns whether it was inserted.
+    bool insert(K const& key, V const& value) {
+        return this->emplace(key, value, false);
+    }
+
+    // Insert key, or overwrite the value of an existing one; returns whether it was inserted.
+    bool insert_or_assign(K const& key, V const& value) {
+        return this->emplace(key, value, true);
+    }
+
+    constexpr bool is_empty() const noexcept {
+        return m_size == 0;
+    }
+
+    // The first entry whose key is not less than key; the start of a range scan.
+    const_iterator_type lower_bound(K const& key) const {
+        return const_cast<btree_map*>(this)->lower_bound(key);
+    }
+
+    iterator_type lower_bound(K const& key) {
+        if (m_root == nullptr) {
+            return {};
+        }
+        auto* leaf = this->find_leaf(key);
+        return iterator_type(leaf, prelude::btree_rank<false>(leaf->keys, leaf->count, key)).skip_empty();
+    }
+
+    constexpr size_type size() const noexcept {
+        return m_size;
+    }
+
+    V& operator [](K const& key) {
+        if (auto* value = this->find(key)) {
+            return *value;
+        }
+        this->insert(key, V());
+        return *this->find(key);
+    }
+
+    friend void swap(btree_map& lhs, btree_map& rhs) noexcept {
+        std::swap(lhs.m_root, rhs.m_root);
+        std::swap(lhs.m_first, rhs.m_first);
+        std::swap(lhs.m_height, rhs.m_height);
+        std::swap(lhs.m_size, rhs.m_size);
+    }
+
+private:
+    // Storage for an inner node. tree_node carries no alignment of its own, so inner nodes are
+    // allocated as line-aligned blocks of the same size.
+    struct alignas(k_cache_line_size) inner_block {
+        alignas(inner_type) unsigned char bytes[sizeof(inner_type)];
+    };
+
+    using inner_allocator = prelude::node_allocator<inner_block>;
+
+    // Children of the lowest inner level are leaves, stored in the tree_node child slots.
+    static leaf_type* as_leaf(void* node) noexcept {
+        return static_cast<leaf_type*>(node);
+    }
+
+    inner_type* make_inner() {
+        auto* inner = ::new(inner_allocator().allocate(1)) inner_type();
+        inner->data.count = 0;
+        return inner;
+    }
+
+    leaf_type* find_leaf(K const& key) const {
+        void* node = m_root;
+        for (auto level = m_height; level > 0; --level) {
+            auto* inner = static_cast<inner_type*>(node);
+            auto const i = prelude::btree_rank<true>(inner->data.keys, inner->data.count - 1, key);
+            node = inner->children[i];
+            prelude::prefetch(node);
+        }
+        return btree_map::as_leaf(node);
+    }
+
+    bool emplace(K const& key, V const& value, bool assign) {
+        auto leaf_alloc = prelude::node_allocator<leaf_type>();
+        if (m_root == nullptr) {
+            m_first = ::new(leaf_alloc.allocate(1)) leaf_type();
+            m_root = m_first;
+        }
+
+        // Remember the way down, so that splits can be pushed back up.
+        inner_type* path[k_max_height];
+        size_type slots[k_max_height];
+        void* node = m_root;
+        for (size_type level = 0; level < m_height; ++level) {
+            auto* inner = static_cast<inner_type*>(node);
+            path[level] = inner;
+            slots[level] = prelude::btree_rank<true>(inner->data.keys, inner->data.count - 1, key);
+            node = inner->children[slots[level]];
+        }
+        auto* leaf = btree_map::as_leaf(node);
+        auto i = prelude::btree_rank<false>(leaf->keys, leaf->count, key);
+        if (i < leaf->count && !(key < leaf->keys[i])) {
+            if (assign) {
+                leaf->values[i] = value;
+            }
+            return false;
+        }
+        ++m_size;
+
+        if (leaf->count < L) {
+            btree_map::insert_at(leaf, i, key, value);
+            return true;
+        }
+
+        // Split the full leaf in half and put the entry into whichever half it belongs to.
+        auto* right = ::new(leaf_alloc.allocate(1)) leaf_type();
+        auto const keep = L / 2;
+        for (auto j = keep; j < L; ++j) {
+            right->keys[j - keep] = static_cast<K&&>(leaf->keys[j]);
+            right->values[j - keep] = static_cast<V&&>(leaf->values[j]);
+        }
+        right->count = L - keep;
+        leaf->count = keep;
+        right->next = leaf->next;
+        leaf->next = right;
+        if (i <= keep) {
+            btree_map::insert_at(leaf, i, key, value);
+        }
+        else {
+            btree_map::insert_at(right, i - keep, key, value);
+        }
+
+        auto separator = right->keys[0];
+        void* child = right;
+        for (auto level = m_height; level-- > 0; ) {
+            auto* inner = path[level];
+            auto const slot = slots[level];
+            if (inner->data.count < N) {
+                btree_map::insert_child(inner, slot, separator, child);
+                return true;
+            }
+            child = this->split_inner(inner, slot, separator, child);
+        }
+
+        // The root itself split; grow the tree by one level.
+        auto* root = this->make_inner();
+        root->children[0] = static_cast<inner_type*>(m_root);
+        root->children[1] = static_cast<inner_type*>(child);
+        root->data.keys[0] = separator;
+        root->data.count = 2;
+        m_root = root;
+        ++m_height;
+        return true;
+    }
+
+    static void insert_at(leaf_type* leaf, size_type i, K const& key, V const& value) {
+        for (auto j = leaf->count; j > i; --j) {
+            leaf->keys[j] = static_cast<K&&>(leaf->keys[j - 1]);
+            leaf->values[j] = static_cast<V&&>(leaf->values[j - 1]);
+        }
+        leaf->keys[i] = key;
+        leaf->values[i] = value;
+        ++leaf->count;
+    }
+
+    // Put child right after children[slot], with separator in front of it.
+    static void insert_child(inner_type* inner, size_type slot, K const& separator, void* child) {
+        auto& data = inner->data;
+        for (auto j = data.count; j > slot + 1; --j) {
+            inner->children[j] = inner->children[j - 1];
+            data.keys[j - 1] = static_cast<K&&>(data.keys[j - 2]);
+        }
+        inner->children[slot + 1] = static_cast<inner_type*>(child);
+        data.keys[slot] = separator;
+        ++data.count;
+    }
+
+    // Insert child after children[slot] of a full inner node by splitting it. Returns the new right
+    // half and replaces separator with the key to push up into the parent.
+    inner_type* split_inner(inner_type* inner, size_type slot, K& separator, void* child) {
+        auto& data = inner->data;
+
+        // Lay out all N + 1 children and N keys in order first, then deal them to the two halves.
+        K keys[N];
+        void* children[N + 1];
+        for (size_type j = 0; j <= slot; ++j) {
+            children[j] = inner->children[j];
+        }
+        children[slot + 1] = child;
+        for (auto j = slot + 1; j < N; ++j) {
+            children[j + 1] = inner->children[j];
+        }
+        for (size_type j = 0; j < slot; ++j) {
+            keys[j] = static_cast<K&&>(data.keys[j]);
+        }
+        keys[slot] = separator;
+        for (auto j = slot; j < N - 1; ++j) {
+            keys[j + 1] = static_cast<K&&>(data.keys[j]);
+        }
+
+        auto* right = this->make_inner();
+        auto const left_count = (N + 1) / 2;
+        for (size_type j = 0; j < left_count; ++j) {
+            inner->children[j] = static_cast<inner_type*>(children[j]);
+        }
+        for (auto j = left_count; j < N + 1; ++j) {
+            right->children[j - left_count] = static_cast<inner_type*>(children[j]);
+        }
+        for (size_type j = 0; j + 1 < left_count; ++j) {
+            data.keys[j] = static_cast<K&&>(keys[j]);
+        }
+        for (auto j = left_count; j < N; ++j) {
+            right->data.keys[j - left_count] = static_cast<K&&>(keys[j]);
+        }
+        data.count = left_count;
+        right->data.count = N + 1 - left_count;
+        separator = static_cast<K&&>(keys[left_count - 1]);
+        return right;
+    }
+
+    void destroy(void* node, size_type level) noexcept {
+        if (level == 0) {
+            auto* leaf = btree_map::as_leaf(node);
+            leaf->~leaf_type();
+            prelude::node_allocator<leaf_type>().deallocate(leaf, 1);
+            return;
+        }
+        auto* inner = static_cast<inner_type*>(node);
+        for (size_type i = 0; i < inner->data.count; ++i) {
+            this->destroy(inner->children[i], level - 1);
+        }
+        inner->~inner_type();
+        inner_allocator().deallocate(reinterpret_cast<inner_block*>(inner), 1);
+    }
+
+    void* m_root = nullptr;
+    leaf_type* m_first = nullptr;
+    size_type m_height = 0;
+    size_type m_size = 0;
+};
+
+template<typename Map, bool Const>
+class btree_iterator {
+public:
+    using leaf_type = Map::leaf_type;
+    using size_type = prelude::size_t;
+    using value_type = btree_entry<typename Map::key_type, typename Map::mapped_type>;
+    using reference_type = std::conditional_t<Const, typename Map::const_reference_type, typename Map::reference_type>;
+    using const_reference_type = Map::const_reference_type;
+
+    constexpr btree_iterator() noexcept = default;
+
+    constexpr btree_iterator(leaf_type* leaf, size_type index) noexcept
+        : m_leaf(leaf), m_index(index) {}
+
+    constexpr operator btree_iterator<Map, true>() const noexcept {
+        return { m_leaf, m_index };
+    }
+
+    // Step over the end of the current leaf, and over leaves emptied by erase.
+    constexpr btree_iterator& skip_empty() noexcept {
+        while (m_leaf != nullptr && m_index == m_leaf->count) {
+            m_leaf = m_leaf->next;
+            m_index = 0;
+        }
+        return *this;
+    }
+
+    constexpr reference_type operator *() const {
+        return { m_leaf->keys[m_index], m_leaf->values[m_index] };
+    }
+
+    constexpr btree_iterator& operator ++() noexcept {
+        ++m_index;
+        return this->skip_empty();
+    }
+
+    constexpr btree_iterator operator ++(int) noexcept {
+        auto ret = *this;
+        ++*this;
+        return ret;
+    }
+
+    constexpr bool operator ==(btree_iterator const& other) const noexcept = default;
+
+private:
+    leaf_type* m_leaf = nullptr;
+    size_type m_index = 0;
+};
+
+} // namespace prelude
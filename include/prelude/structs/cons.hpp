@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+
 #include "../defs.hpp"
 #include "../algos/data.hpp"
 #include "../utils/allocator.hpp"
@@ -12,41 +16,54 @@ struct cons_iterator;
 template<typename T>
 using cons_const_iterator = cons_iterator<T>;
 
-template<typename T, typename Alloc = prelude::node_allocator<cons<T>>>
+/**
+ * @brief A cons list stored as runs of contiguous elements. A cell holds its first element in head
+ * and the remaining count - 1 elements of its run packed right behind it, followed by the link to
+ * the next run in tail. A cell built by hand is a run of one, just like a classic cons cell, while
+ * from_range lays out the whole list as a single run in one allocation, so a cons<int> spends four
+ * bytes per element instead of a pointer and allocator padding per element.
+ *
+ * Because a run extends past the cell object, cells are not copyable; a list is passed around by
+ * pointer to its first cell. Runs are allocated from node_allocator, which must be stateless, and
+ * given back with cons::release.
+ *
+ * @tparam T The element type.
+ */
+template<typename T>
 struct cons {
     using value_type = T;
     using size_type = prelude::size_t;
+    using allocator_type = prelude::node_allocator<cons>;
     using iterator_type = cons_iterator<T>;
     using const_iterator_type = cons_const_iterator<T>;
 
+    // Runs are capped so that the count packs next to a small head without padding.
+    static constexpr size_type k_max_run = UINT32_MAX;
+
+    cons* tail;
+    std::uint32_t count;
     T head;
-    void* tail;
-    [[no_unique_address]] Alloc alloc = {};
 
-    constexpr cons(T const& head, cons<T>* tail = nullptr) noexcept
-        : head(head), tail(tail) {}
+    constexpr cons(T const& head, cons* tail = nullptr)
+        : tail(tail), count(1), head(head) {}
 
-    constexpr cons(T&& head, cons<T>* tail = nullptr) noexcept
-        : head(static_cast<T&&>(head)), tail(tail) {}
+    constexpr cons(T&& head, cons* tail = nullptr) noexcept
+        : tail(tail), count(1), head(static_cast<T&&>(head)) {}
 
-    constexpr cons(T const& head, cons<void>* tail) noexcept
-        : head(head), tail(tail) {}
+    cons(cons const&) = delete;
 
-    constexpr cons(T&& head, cons<void>* tail) noexcept
-        : head(static_cast<T&&>(head)), tail(tail) {}
+    cons& operator =(cons const&) = delete;
 
-    constexpr T const& back() const {
+    T const& back() const {
         auto* it = this;
         while (it->tail != nullptr) {
-            it = static_cast<cons<T>*>(it->tail);
+            it = it->tail;
         }
-        return it->head;
+        return (*it)[it->count - 1];
     }
 
-    const_iterator_type begin() const noexcept;
-
-    iterator_type begin() noexcept {
-        return { static_cast<cons<T> const&>(*this).begin() };
+    const_iterator_type begin() const noexcept {
+        return { this, 0 };
     }
 
     const_iterator_type cbegin() const noexcept {
@@ -57,27 +74,56 @@ struct cons {
         return this->end();
     }
 
-    constexpr iterator_type end() const noexcept;
+    /**
+     * @brief A new list holding copies of the elements of lhs followed by rhs, which is linked to
+     * rather than copied. The copies take a single run.
+     */
+    static cons* concat(cons const* lhs, cons* rhs) {
+        if (lhs == nullptr) {
+            return rhs;
+        }
+        auto* result = cons::from_range(lhs->begin(), const_iterator_type());
+        auto* run = result;
+        while (run->tail != nullptr) {
+            run = run->tail;
+        }
+        run->tail = rhs;
+        return result;
+    }
 
-    constexpr const_iterator_type end() noexcept {
-        return { static_cast<cons<T> const&>(*this).end() };
+    constexpr const_iterator_type end() const noexcept {
+        return {};
     }
 
-    // TODO: write a push_node iterator adaptor for this.
-    static constexpr cons<T> from_list(std::initializer_list<T> list) {
-        return cons<T>::from_range(list.begin(), list.end());
+    static cons* from_list(std::initializer_list<T> list) {
+        return cons::from_range(list.begin(), list.end());
     }
 
-    template<typename InIt, typename InIt>
-    static constexpr cons<T> from_range(InIt first, InIt last) {
-        auto* sentinel = alloc.allocate(1);
-        auto* it = sentinel;
-        while (first != last) {
-            it->tail = alloc.new_object(*first++);
-            it = static_cast<cons<T>*>(it->tail);
+    // Lays the whole range out as one run with a single allocation, or as runs of k_max_run for
+    // longer ranges. The range is traversed twice, once to count it, so InIt must be a forward
+    // iterator.
+    template<typename InIt>
+    static cons* from_range(InIt first, InIt last) {
+        size_type n = 0;
+        for (auto it = first; it != last; ++it) {
+            ++n;
+        }
+        cons* result = nullptr;
+        auto** link = &result;
+        while (n > 0) {
+            auto const run_size = n < k_max_run ? n : k_max_run;
+            auto* run = ::new(allocator_type().allocate(cons::cells_for(run_size))) cons(*first);
+            ++first;
+            auto* rest = run->rest();
+            while (run->count < run_size) {
+                ::new(rest + run->count - 1) T(*first);
+                ++run->count;
+                ++first;
+            }
+            *link = run;
+            link = &run->tail;
+            n -= run_size;
         }
-        auto result = sentinel->tail;
-        alloc.deallocate(sentinel, 1);
         return result;
     }
 
@@ -85,17 +131,52 @@ struct cons {
         return head;
     }
 
-    constexpr T const& operator [](size_type i) const {
-        if (i == 0) {
-            return head;
+    // Destroy every element of the list and give its runs back to the allocator.
+    static void release(cons* list) noexcept {
+        while (list != nullptr) {
+            auto* tail = list->tail;
+            auto const cells = cons::cells_for(list->count);
+            prelude::destroy(list->rest(), list->rest() + list->count - 1);
+            list->~cons();
+            allocator_type().deallocate(list, cells);
+            list = tail;
         }
-        return static_cast<cons<T>*>(tail)[i - 1];
     }
 
-    constexpr cons<T> operator +(cons<T> const& other) const {
-        
+    size_type size() const noexcept {
+        auto result = 0uz;
+        for (auto* it = this; it != nullptr; it = it->tail) {
+            result += it->count;
+        }
+        return result;
+    }
+
+    // Skips whole runs, so this is linear in the number of runs rather than in i.
+    T const& operator [](size_type i) const {
+        auto* it = this;
+        while (i >= it->count) {
+            i -= it->count;
+            it = it->tail;
+        }
+        return i == 0 ? it->head : it->rest()[i - 1];
+    }
+
+private:
+    // Cell-sized units to allocate for a run of n; a run of one is exactly one cell.
+    static constexpr size_type cells_for(size_type n) noexcept {
+        return (sizeof(cons) + (n - 1) * sizeof(T) + sizeof(cons) - 1) / sizeof(cons);
+    }
+
+    // The elements after head, packed right behind this cell.
+    T const* rest() const noexcept {
+        return std::launder(reinterpret_cast<T const*>(this + 1));
     }
 
+    T* rest() noexcept {
+        return std::launder(reinterpret_cast<T*>(this + 1));
+    }
+
+    friend struct cons_iterator<T>;
 };
 
 template<>
@@ -108,4 +189,42 @@ struct cons<void> {
 
 using nil_t = cons<void>;
 
-} // namespace prelude
\ No newline at end of file
+template<typename T>
+struct cons_iterator {
+    using value_type = T;
+    using size_type = prelude::size_t;
+    using difference_type = prelude::ssize_t;
+    using pointer_type = T const*;
+    using const_pointer_type = T const*;
+    using reference_type = T const&;
+    using const_reference_type = T const&;
+
+    cons<T> const* run = nullptr;
+    size_type index = 0;
+
+    T const& operator *() const {
+        return index == 0 ? run->head : run->rest()[index - 1];
+    }
+
+    T const* operator ->() const {
+        return &**this;
+    }
+
+    cons_iterator& operator ++() noexcept {
+        if (++index == run->count) {
+            run = run->tail;
+            index = 0;
+        }
+        return *this;
+    }
+
+    cons_iterator operator ++(int) noexcept {
+        auto ret = *this;
+        ++*this;
+        return ret;
+    }
+
+    constexpr bool operator ==(cons_iterator const& other) const noexcept = default;
+};
+
+} // namespace prelude
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <bit>
+#include <new>
+#include <utility>
+
+#include "../defs.hpp"
+#include "../utils/allocator.hpp"
+#include "linked.hpp"
+
+namespace prelude {
+
+/**
+ * @brief An immutable sorted set laid out in Eytzinger (breadth-first) order: the children of slot
+ * i are slots 2i and 2i + 1, so a search walks down an implicit complete tree without following
+ * any pointers. The descent is branchless, going right by adding the comparison result to the
+ * index, and it prefetches the block of descendants a few levels down so that the memory latency
+ * of the next levels overlaps with the comparisons of this one.
+ *
+ * Built once by freeze() from a binary search tree and queried many times; it is meant for
+ * read-mostly lookup tables.
+ *
+ * @tparam T The element type.
+ *
+ * @example
+ * @code
+ *      auto table = freeze(root);
+ *      if (auto const* hit = table.find(42)) { ... }
+ * @endcode
+ */
+template<typename T>
+class frozen_tree {
+public:
+    using value_type = T;
+    using size_type = prelude::size_t;
+    using const_pointer_type = T const*;
+
+    // Descendants this many slots below i, i.e. log2 of it levels down, share one cache line.
+    static constexpr size_type k_prefetch_stride =
+        std::bit_floor(sizeof(T) < k_cache_line_size ? k_cache_line_size / sizeof(T) : 1);
+
+    constexpr frozen_tree() noexcept = default;
+
+    frozen_tree(frozen_tree const& other)
+        : m_data(frozen_tree::allocate(other.m_size)), m_size(other.m_size) {
+
+        for (size_type i = 1; i <= m_size; ++i) {
+            ::new(m_data + i) T(other.m_data[i]);
+        }
+    }
+
+    frozen_tree(frozen_tree&& other) noexcept
+        : m_data(other.m_data), m_size(other.m_size) {
+
+        other.m_data = nullptr;
+        other.m_size = 0;
+    }
+
+    ~frozen_tree() {
+        if (m_data != nullptr) {
+            prelude::destroy(m_data + 1, m_data + m_size + 1);
+            frozen_tree::deallocate(m_data, m_size);
+        }
+    }
+
+    frozen_tree& operator =(frozen_tree const& other) {
+        auto tmp = other;
+        swap(*this, tmp);
+        return *this;
+    }
+
+    frozen_tree& operator =(frozen_tree&& other) noexcept {
+        auto tmp = static_cast<frozen_tree&&>(other);
+        swap(*this, tmp);
+        return *this;
+    }
+
+    /**
+     * @brief Copy a binary search tree, whose in-order traversal must be sorted, into Eytzinger
+     * order. The in-order walk is iterative and drops each element straight into its final slot.
+     */
+    static frozen_tree freeze(binary_tree_node<T> const* root) {
+        auto result = frozen_tree();
+        auto const n = frozen_tree::count(root);
+        if (n == 0) {
+            return result;
+        }
+        result.m_data = frozen_tree::allocate(n);
+
+        // Slots are visited in the in-order of the implicit tree, starting from its leftmost slot.
+        auto slot = 1uz;
+        while (2 * slot <= n) {
+            slot *= 2;
+        }
+        frozen_tree::walk(root, [&](T const& value) {
+            ::new(result.m_data + slot) T(value);
+            ++result.m_size;
+            if (2 * slot + 1 <= n) {
+                slot = 2 * slot + 1;
+                while (2 * slot <= n) {
+                    slot *= 2;
+                }
+            }
+            else {
+                slot >>= std::countr_one(slot) + 1;
+            }
+        });
+        return result;
+    }
+
+    template<typename K>
+    bool contains(K const& key) const {
+        return this->find(key) != nullptr;
+    }
+
+    template<typename K>
+    bool contains(K const& key, auto&& pred) const {
+        return this->find(key, pred) != nullptr;
+    }
+
+    constexpr bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    // The element equivalent to key, or nullptr.
+    template<typename K>
+    T const* find(K const& key) const {
+        return this->find(key, [](auto const& lhs, auto const& rhs) { return lhs < rhs; });
+    }
+
+    template<typename K>
+    T const* find(K const& key, auto&& pred) const {
+        auto const* result = this->lower_bound(key, pred);
+        return result != nullptr && !pred(key, *result) ? result : nullptr;
+    }
+
+    constexpr bool is_empty() const noexcept {
+        return m_size == 0;
+    }
+
+    // The smallest element not less than key, or nullptr.
+    template<typename K>
+    T const* lower_bound(K const& key) const {
+        return this->lower_bound(key, [](auto const& lhs, auto const& rhs) { return lhs < rhs; });
+    }
+
+    template<typename K>
+    T const* lower_bound(K const& key, auto&& pred) const {
+        auto i = 1uz;
+        while (i <= m_size) {
+            prelude::prefetch(m_data + i * k_prefetch_stride);
+            i = 2 * i + static_cast<size_type>(pred(m_data[i], key));
+        }
+        // Every right turn appended a 1 bit; dropping them, and the last left turn, leads back
+        // to the last slot where we went left, which is the answer.
+        i >>= std::countr_one(i) + 1;
+        return i == 0 ? nullptr : m_data + i;
+    }
+
+    constexpr size_type size() const noexcept {
+        return m_size;
+    }
+
+    friend void swap(frozen_tree& lhs, frozen_tree& rhs) noexcept {
+        std::swap(lhs.m_data, rhs.m_data);
+        std::swap(lhs.m_size, rhs.m_size);
+    }
+
+private:
+    // Slot 0 is unused so that the children of i are 2i and 2i + 1. The array is aligned to a
+    // cache line so that each prefetched block of descendants sits in as few lines as possible.
+    static T* allocate(size_type n) {
+        return static_cast<T*>(::operator new((n + 1) * sizeof(T), std::align_val_t(k_cache_line_size)));
+    }
+
+    static void deallocate(T* data, size_type n) noexcept {
+        ::operator delete(data, (n + 1) * sizeof(T), std::align_val_t(k_cache_line_size));
+    }
+
+    static size_type count(binary_tree_node<T> const* root) {
+        auto result = 0uz;
+        frozen_tree::walk(root, [&](T const&) { ++result; });
+        return result;
+    }
+
+    // In-order traversal with an explicit stack, which grows by doubling.
+    static void walk(binary_tree_node<T> const* root, auto&& visit) {
+        using node_pointer = binary_tree_node<T> const*;
+        auto alloc = prelude::basic_allocator<node_pointer>();
+        size_type capacity = 64;
+        size_type depth = 0;
+        auto* stack = alloc.allocate(capacity);
+        auto const* it = root;
+        while (it != nullptr || depth > 0) {
+            while (it != nullptr) {
+                if (depth == capacity) {
+                    auto* grown = alloc.allocate(2 * capacity);
+                    prelude::relocate(stack, depth, grown);
+                    alloc.deallocate(stack, capacity);
+                    stack = grown;
+                    capacity *= 2;
+                }
+                stack[depth++] = it;
+                it = it->left;
+            }
+            it = stack[--depth];
+            visit(it->data);
+            it = it->right;
+        }
+        alloc.deallocate(stack, capacity);
+    }
+
+    T* m_data = nullptr;
+    size_type m_size = 0;
+};
+
+template<typename T>
+frozen_tree<T> freeze(binary_tree_node<T> const* root) {
+    return frozen_tree<T>::freeze(root);
+}
+
+} // namespace prelude
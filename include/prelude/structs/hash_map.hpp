@@ -0,0 +1,499 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "../defs.hpp"
+#include "../utils/allocator.hpp"
+
+namespace prelude {
+
+// Control bytes: a full slot holds the low 7 bits of its hash, so it is never negative.
+inline constexpr std::int8_t k_ctrl_empty = -128;
+inline constexpr std::int8_t k_ctrl_deleted = -2;
+
+// Slots are probed 16 at a time, one SSE2 register of control bytes.
+inline constexpr prelude::size_t k_group_size = 16;
+
+/**
+ * @brief A group of 16 control bytes, and the bitmasks of the slots in it that match a hash, are
+ * empty, or are free for an insertion. Bit i of a mask stands for slot i of the group.
+ */
+struct alignas(k_group_size) ctrl_group {
+    std::int8_t bytes[k_group_size];
+
+    std::uint32_t match(std::int8_t h2) const noexcept {
+#if defined(__SSE2__)
+        auto const ctrl = _mm_load_si128(reinterpret_cast<__m128i const*>(bytes));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2))));
+#else
+        std::uint32_t result = 0;
+        for (prelude::size_t i = 0; i < k_group_size; ++i) {
+            result |= static_cast<std::uint32_t>(bytes[i] == h2) << i;
+        }
+        return result;
+#endif
+    }
+
+    std::uint32_t match_empty() const noexcept {
+        return this->match(k_ctrl_empty);
+    }
+
+    // Empty or deleted: the control bytes with the sign bit set.
+    std::uint32_t match_free() const noexcept {
+#if defined(__SSE2__)
+        auto const ctrl = _mm_load_si128(reinterpret_cast<__m128i const*>(bytes));
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl));
+#else
+        std::uint32_t result = 0;
+        for (prelude::size_t i = 0; i < k_group_size; ++i) {
+            result |= static_cast<std::uint32_t>(bytes[i] < 0) << i;
+        }
+        return result;
+#endif
+    }
+};
+
+template<typename K, typename V>
+struct hash_map_entry {
+    K key;
+    V value;
+};
+
+template<typename Map, bool Const>
+class hash_map_iterator;
+
+/**
+ * @brief An open-addressing hash map in the style of Swiss tables. Next to the flat slot array is
+ * one control byte per slot holding 7 bits of the slot's hash, so a lookup compares 16 candidates
+ * at once with SSE2 and only touches the slots whose byte matches; a portable loop stands in where
+ * SSE2 is missing. Probing moves from group to group on a triangular sequence and stops at the
+ * first group with an empty slot.
+ *
+ * Erasing a slot whose group still has an empty slot leaves it empty rather than a tombstone,
+ * since no probe can have passed through that group. Tombstones count against the load and are
+ * cleared by the next rehash. The table grows at 7/8 load.
+ *
+ * Hash and Eq that both declare is_transparent enable lookups by any key type they accept, e.g.
+ * finding a std::string key by std::string_view without constructing a string.
+ *
+ * @tparam K The key type.
+ * @tparam V The mapped type.
+ * @tparam Hash The hash function.
+ * @tparam Eq The key equality.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>, typename Eq = std::equal_to<K>>
+class hash_map {
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = hash_map_entry<K, V>;
+    using size_type = prelude::size_t;
+    using reference_type = value_type&;
+    using const_reference_type = value_type const&;
+    using iterator_type = hash_map_iterator<hash_map, false>;
+    using const_iterator_type = hash_map_iterator<hash_map, true>;
+
+    static constexpr bool k_transparent = requires {
+        typename Hash::is_transparent;
+        typename Eq::is_transparent;
+    };
+
+    hash_map() noexcept = default;
+
+    hash_map(hash_map const& other)
+        : m_hash(other.m_hash), m_eq(other.m_eq) {
+
+        this->reserve(other.m_size);
+        for (auto const& entry : other) {
+            this->insert(entry.key, entry.value);
+        }
+    }
+
+    hash_map(hash_map&& other) noexcept
+        : m_ctrl(other.m_ctrl),
+          m_slots(other.m_slots),
+          m_capacity(other.m_capacity),
+          m_size(other.m_size),
+          m_growth_left(other.m_growth_left),
+          m_hash(static_cast<Hash&&>(other.m_hash)),
+          m_eq(static_cast<Eq&&>(other.m_eq)) {
+
+        other.m_ctrl = nullptr;
+        other.m_slots = nullptr;
+        other.m_capacity = 0;
+        other.m_size = 0;
+        other.m_growth_left = 0;
+    }
+
+    ~hash_map() {
+        this->destroy_slots();
+        this->deallocate();
+    }
+
+    hash_map& operator =(hash_map const& other) {
+        if (this != &other) {
+            auto tmp = other;
+            swap(*this, tmp);
+        }
+        return *this;
+    }
+
+    hash_map& operator =(hash_map&& other) noexcept {
+        auto tmp = static_cast<hash_map&&>(other);
+        swap(*this, tmp);
+        return *this;
+    }
+
+    const_iterator_type begin() const noexcept {
+        return const_iterator_type(this, 0).skip_free();
+    }
+
+    iterator_type begin() noexcept {
+        return iterator_type(this, 0).skip_free();
+    }
+
+    constexpr size_type capacity() const noexcept {
+        return m_capacity;
+    }
+
+    const_iterator_type cbegin() const noexcept {
+        return this->begin();
+    }
+
+    const_iterator_type cend() const noexcept {
+        return this->end();
+    }
+
+    // Destroy every entry but keep the table.
+    void clear() noexcept {
+        this->destroy_slots();
+        if (m_ctrl != nullptr) {
+            std::memset(m_ctrl, k_ctrl_empty, m_capacity);
+        }
+        m_size = 0;
+        m_growth_left = hash_map::max_load(m_capacity);
+    }
+
+    template<typename Q = K>
+    bool contains(Q const& key) const requires (std::is_same_v<Q, K> || k_transparent) {
+        return this->find(key) != nullptr;
+    }
+
+    constexpr bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    const_iterator_type end() const noexcept {
+        return { this, m_capacity };
+    }
+
+    iterator_type end() noexcept {
+        return { this, m_capacity };
+    }
+
+    template<typename Q = K>
+    bool erase(Q const& key) requires (std::is_same_v<Q, K> || k_transparent) {
+        auto const slot = this->find_slot(key);
+        if (slot == m_capacity) {
+            return false;
+        }
+        m_slots[slot].~value_type();
+        --m_size;
+        // A probe only moves past a group that has no empty slot, so if this group still has one,
+        // nothing can be relying on this slot having been full.
+        auto const& group = this->group_at(slot / k_group_size);
+        if (group.match_empty() != 0) {
+            m_ctrl[slot] = k_ctrl_empty;
+            ++m_growth_left;
+        }
+        else {
+            m_ctrl[slot] = k_ctrl_deleted;
+        }
+        return true;
+    }
+
+    template<typename Q = K>
+    V const* find(Q const& key) const requires (std::is_same_v<Q, K> || k_transparent) {
+        auto const slot = this->find_slot(key);
+        return slot == m_capacity ? nullptr : &m_slots[slot].value;
+    }
+
+    template<typename Q = K>
+    V* find(Q const& key) requires (std::is_same_v<Q, K> || k_transparent) {
+        auto const slot = this->find_slot(key);
+        return slot == m_capacity ? nullptr : &m_slots[slot].value;
+    }
+
+    // Insert key unless it is already present; returns whether it was inserted.
+    template<typename... Args>
+    bool emplace(K const& key, Args&&... args) {
+        auto const hash = this->hash_of(key);
+        if (this->find_slot(key, hash) != m_capacity) {
+            return false;
+        }
+        auto const slot = this->prepare_insert(hash);
+        ::new(m_slots + slot) value_type { key, V(static_cast<Args&&>(args)...) };
+        return true;
+    }
+
+    bool insert(K const& key, V const& value) {
+        return this->emplace(key, value);
+    }
+
+    bool insert(K const& key, V&& value) {
+        return this->emplace(key, static_cast<V&&>(value));
+    }
+
+    // Insert key, or overwrite the value of an existing one; returns whether it was inserted.
+    bool insert_or_assign(K const& key, V const& value) {
+        if (auto* existing = this->find(key)) {
+            *existing = value;
+            return false;
+        }
+        return this->emplace(key, value);
+    }
+
+    constexpr bool is_empty() const noexcept {
+        return m_size == 0;
+    }
+
+    // The fraction of slots holding an entry.
+    double load_factor() const noexcept {
+        return m_capacity == 0 ? 0.0 : static_cast<double>(m_size) / static_cast<double>(m_capacity);
+    }
+
+    // Make room for n entries without another rehash.
+    void reserve(size_type n) {
+        auto capacity = k_group_size;
+        while (hash_map::max_load(capacity) < n) {
+            capacity *= 2;
+        }
+        if (capacity > m_capacity) {
+            this->rehash(capacity);
+        }
+    }
+
+    constexpr size_type size() const noexcept {
+        return m_size;
+    }
+
+    V& operator [](K const& key) {
+        auto const hash = this->hash_of(key);
+        auto slot = this->find_slot(key, hash);
+        if (slot == m_capacity) {
+            slot = this->prepare_insert(hash);
+            ::new(m_slots + slot) value_type { key, V() };
+        }
+        return m_slots[slot].value;
+    }
+
+    friend void swap(hash_map& lhs, hash_map& rhs) noexcept {
+        std::swap(lhs.m_ctrl, rhs.m_ctrl);
+        std::swap(lhs.m_slots, rhs.m_slots);
+        std::swap(lhs.m_capacity, rhs.m_capacity);
+        std::swap(lhs.m_size, rhs.m_size);
+        std::swap(lhs.m_growth_left, rhs.m_growth_left);
+        std::swap(lhs.m_hash, rhs.m_hash);
+        std::swap(lhs.m_eq, rhs.m_eq);
+    }
+
+private:
+    friend class hash_map_iterator<hash_map, false>;
+    friend class hash_map_iterator<hash_map, true>;
+
+    static constexpr size_type max_load(size_type capacity) noexcept {
+        return capacity - capacity / 8;
+    }
+
+    // Standard hashes are often the identity, so spread every input bit over the whole word
+    // before taking the group index from the high bits and the control byte from the low ones.
+    template<typename Q>
+    size_type hash_of(Q const& key) const {
+        auto h = static_cast<std::uint64_t>(m_hash(key));
+        h ^= h >> 32;
+        h *= 0x9e3779b97f4a7c15ull;
+        h ^= h >> 29;
+        return h;
+    }
+
+    static std::int8_t h2(size_type hash) noexcept {
+        return static_cast<std::int8_t>(hash & 0x7f);
+    }
+
+    ctrl_group const& group_at(size_type g) const noexcept {
+        return *std::launder(reinterpret_cast<ctrl_group const*>(m_ctrl + g * k_group_size));
+    }
+
+    template<typename Q>
+    size_type find_slot(Q const& key) const {
+        return this->find_slot(key, this->hash_of(key));
+    }
+
+    // The slot holding key, or m_capacity.
+    template<typename Q>
+    size_type find_slot(Q const& key, size_type hash) const {
+        if (m_capacity == 0) {
+            return m_capacity;
+        }
+        auto const groups_mask = m_capacity / k_group_size - 1;
+        auto g = (hash >> 7) & groups_mask;
+        for (size_type step = 1; ; ++step) {
+            auto const& group = this->group_at(g);
+            for (auto bits = group.match(hash_map::h2(hash)); bits != 0; bits &= bits - 1) {
+                auto const slot = g * k_group_size + std::countr_zero(bits);
+                if (m_eq(m_slots[slot].key, key)) {
+                    return slot;
+                }
+            }
+            if (group.match_empty() != 0 || step > groups_mask) {
+                return m_capacity;
+            }
+            g = (g + step) & groups_mask;
+        }
+    }
+
+    // Claim a free slot for a key with the given hash that is known to be absent.
+    size_type prepare_insert(size_type hash) {
+        if (m_growth_left == 0) {
+            // Mostly tombstones: clean them out at the same size instead of growing.
+            auto const capacity = m_size < hash_map::max_load(m_capacity) / 2 ? m_capacity : m_capacity * 2;
+            this->rehash(capacity < k_group_size ? k_group_size : capacity);
+        }
+        auto const slot = this->free_slot(hash);
+        if (m_ctrl[slot] == k_ctrl_empty) {
+            --m_growth_left;
+        }
+        m_ctrl[slot] = hash_map::h2(hash);
+        ++m_size;
+        return slot;
+    }
+
+    // The first empty or deleted slot on the probe sequence of hash.
+    size_type free_slot(size_type hash) const noexcept {
+        auto const groups_mask = m_capacity / k_group_size - 1;
+        auto g = (hash >> 7) & groups_mask;
+        for (size_type step = 1; ; ++step) {
+            if (auto const bits = this->group_at(g).match_free(); bits != 0) {
+                return g * k_group_size + std::countr_zero(bits);
+            }
+            g = (g + step) & groups_mask;
+        }
+    }
+
+    void rehash(size_type capacity) {
+        auto* old_ctrl = m_ctrl;
+        auto* old_slots = m_slots;
+        auto const old_capacity = m_capacity;
+
+        m_ctrl = reinterpret_cast<std::int8_t*>(prelude::basic_allocator<ctrl_group>().allocate(capacity / k_group_size));
+        m_slots = prelude::basic_allocator<value_type>().allocate(capacity);
+        m_capacity = capacity;
+        std::memset(m_ctrl, k_ctrl_empty, capacity);
+        m_growth_left = hash_map::max_load(capacity) - m_size;
+
+        for (size_type i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] >= 0) {
+                auto const hash = this->hash_of(old_slots[i].key);
+                auto const slot = this->free_slot(hash);
+                m_ctrl[slot] = hash_map::h2(hash);
+                prelude::relocate(old_slots + i, 1, m_slots + slot);
+            }
+        }
+        if (old_ctrl != nullptr) {
+            prelude::basic_allocator<ctrl_group>().deallocate(reinterpret_cast<ctrl_group*>(old_ctrl), old_capacity / k_group_size);
+            prelude::basic_allocator<value_type>().deallocate(old_slots, old_capacity);
+        }
+    }
+
+    void destroy_slots() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<value_type>) {
+            for (size_type i = 0; i < m_capacity; ++i) {
+                if (m_ctrl[i] >= 0) {
+                    m_slots[i].~value_type();
+                }
+            }
+        }
+    }
+
+    void deallocate() noexcept {
+        if (m_ctrl != nullptr) {
+            prelude::basic_allocator<ctrl_group>().deallocate(reinterpret_cast<ctrl_group*>(m_ctrl), m_capacity / k_group_size);
+            prelude::basic_allocator<value_type>().deallocate(m_slots, m_capacity);
+        }
+    }
+
+    std::int8_t* m_ctrl = nullptr;
+    value_type* m_slots = nullptr;
+    size_type m_capacity = 0;
+    size_type m_size = 0;
+    // Empty slots that may still be filled before the load limit; tombstones do not give any back.
+    size_type m_growth_left = 0;
+    [[no_unique_address]] Hash m_hash = {};
+    [[no_unique_address]] Eq m_eq = {};
+};
+
+template<typename Map, bool Const>
+class hash_map_iterator {
+public:
+    using container_type = std::conditional_t<Const, Map const, Map>;
+    using value_type = Map::value_type;
+    using size_type = prelude::size_t;
+    using pointer_type = std::conditional_t<Const, value_type const*, value_type*>;
+    using reference_type = std::conditional_t<Const, value_type const&, value_type&>;
+    using const_reference_type = value_type const&;
+
+    constexpr hash_map_iterator() noexcept = default;
+
+    constexpr hash_map_iterator(container_type* map, size_type slot) noexcept
+        : m_map(map), m_slot(slot) {}
+
+    constexpr operator hash_map_iterator<Map, true>() const noexcept {
+        return { m_map, m_slot };
+    }
+
+    // Advance to the next full slot, or to the end.
+    hash_map_iterator& skip_free() noexcept {
+        while (m_slot < m_map->m_capacity && m_map->m_ctrl[m_slot] < 0) {
+            ++m_slot;
+        }
+        return *this;
+    }
+
+    reference_type operator *() const {
+        return m_map->m_slots[m_slot];
+    }
+
+    pointer_type operator ->() const {
+        return m_map->m_slots + m_slot;
+    }
+
+    hash_map_iterator& operator ++() noexcept {
+        ++m_slot;
+        return this->skip_free();
+    }
+
+    hash_map_iterator operator ++(int) noexcept {
+        auto ret = *this;
+        ++*this;
+        return ret;
+    }
+
+    constexpr bool operator ==(hash_map_iterator const& other) const noexcept {
+        return m_slot == other.m_slot;
+    }
+
+private:
+    container_type* m_map = nullptr;
+    size_type m_slot = 0;
+};
+
+} // namespace prelude
@@ -1,6 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
 #include "../defs.hpp"
+#include "../utils/allocator.hpp"
 
 namespace prelude {
 
@@ -30,7 +37,68 @@ struct binary_tree_node {
     binary_tree_node<T>* right;
 };
 
+// Elements per unrolled_node so that a node, header included, fits in one cache line.
+template<typename T>
+inline constexpr prelude::size_t k_unrolled_capacity =
+    sizeof(T) + 2 * sizeof(void*) >= k_cache_line_size ? 1 : (k_cache_line_size - 2 * sizeof(void*)) / sizeof(T);
+
+/**
+ * @brief A singly linked node that packs up to N elements, so that a traversal touches one cache
+ * line per block rather than one per element. Only the first count slots hold live objects.
+ *
+ * Blocks are split when an insertion finds them full and refilled from their successor when an
+ * erase leaves them less than half full, so every block but the last stays at least half full.
+ *
+ * Nodes are aligned to a cache line, whatever allocator they come from, so that a node of the
+ * default capacity occupies exactly one line instead of straddling two.
+ *
+ * @tparam T The element type.
+ * @tparam N The number of elements per node.
+ */
+template<typename T, prelude::size_t N = k_unrolled_capacity<T>>
+struct alignas(k_cache_line_size) unrolled_node {
+    static_assert(N > 0, "an unrolled node must hold at least one element");
+
+    unrolled_node* next;
+    prelude::size_t count;
+    alignas(T) unsigned char storage[N * sizeof(T)];
+
+    T* data() noexcept {
+        return std::launder(reinterpret_cast<T*>(storage));
+    }
+
+    T& operator [](prelude::size_t i) noexcept {
+        return this->data()[i];
+    }
+};
 
+// An element of an unrolled list: slot index of node. A null node is past the end.
+template<typename T, prelude::size_t N>
+struct unrolled_position {
+    unrolled_node<T, N>* node;
+    prelude::size_t index;
+};
+
+template<typename T, prelude::size_t N, typename Alloc>
+unrolled_node<T, N>* make_unrolled_node(Alloc& alloc, unrolled_node<T, N>* next) {
+    auto* node = ::new(alloc.allocate(1)) unrolled_node<T, N>;
+    node->next = next;
+    node->count = 0;
+    return node;
+}
+
+/**
+ * @brief Destroy every element of an unrolled list and give its nodes back to alloc.
+ */
+template<typename T, prelude::size_t N, typename Alloc = prelude::node_allocator<unrolled_node<T, N>>>
+void clear(unrolled_node<T, N>* head, Alloc alloc = Alloc()) {
+    while (head != nullptr) {
+        auto* next = head->next;
+        prelude::destroy(head->data(), head->data() + head->count);
+        alloc.deallocate(head, 1);
+        head = next;
+    }
+}
 
 template<typename T>
 constexpr void insert_after(singly_linked_node<T>* pos, singly_linked_node<T>* node) {
@@ -52,6 +120,52 @@ constexpr void insert_after(doubly_linked_node<T>* pos, doubly_linked_node<T>* n
     node->prev = pos;
 }
 
+/**
+ * @brief Insert value right after the element at pos and return its position. A full node is
+ * split in half first, except when appending to its end, where a fresh node is started instead so
+ * that lists built front to back stay densely packed.
+ */
+template<typename T, prelude::size_t N, typename Alloc = prelude::node_allocator<unrolled_node<T, N>>>
+unrolled_position<T, N> insert_after(unrolled_position<T, N> pos, T value, Alloc alloc = Alloc()) {
+    auto* node = pos.node;
+    auto index = pos.index + 1;
+    if (node->count == N) {
+        node->next = prelude::make_unrolled_node<T, N>(alloc, node->next);
+        if (index == N) {
+            node = node->next;
+            index = 0;
+        }
+        else {
+            auto const keep = (N + 1) / 2;
+            prelude::relocate(node->data() + keep, N - keep, node->next->data());
+            node->next->count = N - keep;
+            node->count = keep;
+            if (index > keep) {
+                node = node->next;
+                index -= keep;
+            }
+        }
+    }
+    prelude::relocate(node->data() + index, node->count - index, node->data() + index + 1);
+    ::new(node->data() + index) T(static_cast<T&&>(value));
+    ++node->count;
+    return { node, index };
+}
+
+/**
+ * @brief Insert value in front of an unrolled list, which may be empty, and return the new head.
+ */
+template<typename T, prelude::size_t N, typename Alloc = prelude::node_allocator<unrolled_node<T, N>>>
+unrolled_node<T, N>* push_front(unrolled_node<T, N>* head, T value, Alloc alloc = Alloc()) {
+    if (head == nullptr || head->count == N) {
+        head = prelude::make_unrolled_node<T, N>(alloc, head);
+    }
+    prelude::relocate(head->data(), head->count, head->data() + 1);
+    ::new(head->data()) T(static_cast<T&&>(value));
+    ++head->count;
+    return head;
+}
+
 template<typename T>
 constexpr singly_linked_node<T>* last(singly_linked_node<T>* head) {
     if (head == nullptr) {
@@ -68,6 +182,17 @@ constexpr doubly_linked_node<T>* last(doubly_linked_node<T>* head) {
     return reinterpret_cast<doubly_linked_node<T>*>(last(reinterpret_cast<singly_linked_node<T>*>(head)));
 }
 
+template<typename T, prelude::size_t N>
+constexpr unrolled_node<T, N>* last(unrolled_node<T, N>* head) {
+    if (head == nullptr) {
+        return nullptr;
+    }
+    while (head->next != nullptr) {
+        head = head->next;
+    }
+    return head;
+}
+
 template<typename T, prelude::size_t N>
 constexpr prelude::size_t height(tree_node<T, N>* root) {
     if (root == nullptr) {
@@ -96,85 +221,183 @@ constexpr singly_linked_node<T>* middle(singly_linked_node<T>* head) {
 
 template<typename T>
 constexpr doubly_linked_node<T>* middle(doubly_linked_node<T>* head) {
-    return reinterpret_cast<doubly_linked_node<T>*>(reinterpret_cast<singly_linked_node<T>*>(head));
+    return reinterpret_cast<doubly_linked_node<T>*>(middle(reinterpret_cast<singly_linked_node<T>*>(head)));
 }
 
-template<typename T>
-constexpr singly_linked_node<T>* merge(singly_linked_node<T>* head_1, singly_linked_node<T>* head_2, auto&& pred) {
-    if (head_1 == nullptr) {
-        return head_2;
-    }
-    else if (head_2 == nullptr) {
-        return head_1;
-    }
-
-    auto dumb = singly_linked_node<T> { T(), nullptr };
-    auto* it = &dumb;
+// The first and last node of a chain.
+template<typename Node>
+struct node_run {
+    Node* head;
+    Node* tail;
+};
 
+/**
+ * @brief Stable merge of two sorted null-terminated chains, relinking prev as well for doubly linked
+ * nodes. An element of head_2 goes first only if it compares strictly less. tail_1 and tail_2, the
+ * last nodes of the inputs, are only used to report the tail of the result and may be null when the
+ * caller does not need it.
+ */
+template<typename Node>
+constexpr node_run<Node> merge_runs(Node* head_1, Node* tail_1, Node* head_2, Node* tail_2, auto& pred) {
+    Node* head = nullptr;
+    Node* tail = nullptr;
+    auto** link = &head;
     while (head_1 != nullptr && head_2 != nullptr) {
-        if (pred(head_1->data, head_2->data)) {
-            it->next = head_1;
-            head_1 = head_1->next;
-            it = head_1;
+        auto*& from = pred(head_2->data, head_1->data) ? head_2 : head_1;
+        *link = from;
+        if constexpr (requires { from->prev; }) {
+            from->prev = tail;
         }
-        else {
-            it->next = head_2;
-            head_2 = head_2->next;
-            it = head_2;
+        tail = from;
+        link = &from->next;
+        from = from->next;
+    }
+    auto* rest = head_1 != nullptr ? head_1 : head_2;
+    *link = rest;
+    if (rest != nullptr) {
+        if constexpr (requires { rest->prev; }) {
+            rest->prev = tail;
         }
+        tail = head_1 != nullptr ? tail_1 : tail_2;
     }
+    return { head, tail };
+}
 
-    if (head_1 != nullptr) {
-        it->next = head_1;
-        head_1->prev = it;
-    }
-    else if (head_2 != nullptr) {
-        it->next = head_2;
-        head_2->prev = it;
-    }
-    return dumb.next;
+template<typename T>
+constexpr singly_linked_node<T>* merge(singly_linked_node<T>* head_1, singly_linked_node<T>* head_2, auto&& pred) {
+    return merge_runs<singly_linked_node<T>>(head_1, nullptr, head_2, nullptr, pred).head;
 }
 
 template<typename T>
 constexpr doubly_linked_node<T>* merge(doubly_linked_node<T>* head_1, doubly_linked_node<T>* head_2, auto&& pred) {
-    if (head_1 == nullptr) {
-        return head_2;
+    return merge_runs<doubly_linked_node<T>>(head_1, nullptr, head_2, nullptr, pred).head;
+}
+
+/**
+ * @brief Stable k-way merge of sorted null-terminated chains with a loser tree. Each internal node
+ * of the tree remembers the loser of the match played there, so after the winner is taken only the
+ * matches on the path from its leaf to the root are replayed: log2(k) comparisons per element, with
+ * no branching on which of the k inputs is involved. Ties go to the input with the lower index.
+ *
+ * heads is used as the cursor array and is left all null. prev links are relinked for doubly linked
+ * nodes. Returns the head of the merged list.
+ */
+template<typename Node>
+Node* merge_runs(Node** heads, prelude::size_t k, auto& pred) {
+    if (k == 0) {
+        return nullptr;
     }
-    else if (head_2 == nullptr) {
-        return head_1;
+    // Whether input i currently beats input j; an exhausted input loses to everything.
+    auto const beats = [&](prelude::size_t i, prelude::size_t j) {
+        if (heads[i] == nullptr || heads[j] == nullptr) {
+            return heads[j] == nullptr && (heads[i] != nullptr || i < j);
+        }
+        if (pred(heads[j]->data, heads[i]->data)) {
+            return false;
+        }
+        return i < j || pred(heads[i]->data, heads[j]->data);
+    };
+
+    // Leaves are the virtual nodes k..2k-1, internal nodes 1..k-1 hold losers. winners only exists
+    // while the tree is built bottom-up.
+    auto alloc = prelude::basic_allocator<prelude::size_t>();
+    auto* losers = alloc.allocate(2 * k);
+    auto* winners = losers + k;
+    auto const winner_at = [&](prelude::size_t n) {
+        return n >= k ? n - k : winners[n];
+    };
+    for (auto n = k - 1; n >= 1; --n) {
+        auto const lhs = winner_at(2 * n);
+        auto const rhs = winner_at(2 * n + 1);
+        auto const lhs_wins = beats(lhs, rhs);
+        winners[n] = lhs_wins ? lhs : rhs;
+        losers[n] = lhs_wins ? rhs : lhs;
     }
+    auto winner = winner_at(1);
 
-    auto dumb = doubly_linked_node<T> { T(), nullptr, nullptr };
-    auto* it = &dumb;
+    Node* head = nullptr;
+    Node* tail = nullptr;
+    auto** link = &head;
+    while (heads[winner] != nullptr) {
+        auto* node = heads[winner];
+        *link = node;
+        if constexpr (requires { node->prev; }) {
+            node->prev = tail;
+        }
+        tail = node;
+        link = &node->next;
+        heads[winner] = node->next;
+        for (auto n = (winner + k) / 2; n >= 1; n /= 2) {
+            if (beats(losers[n], winner)) {
+                std::swap(losers[n], winner);
+            }
+        }
+    }
+    *link = nullptr;
+    alloc.deallocate(losers, 2 * k);
+    return head;
+}
+
+template<typename T>
+singly_linked_node<T>* merge(singly_linked_node<T>** heads, prelude::size_t k, auto&& pred) {
+    return prelude::merge_runs(heads, k, pred);
+}
 
+template<typename T>
+doubly_linked_node<T>* merge(doubly_linked_node<T>** heads, prelude::size_t k, auto&& pred) {
+    return prelude::merge_runs(heads, k, pred);
+}
+
+/**
+ * @brief Merge two sorted unrolled lists. The result is written into densely packed fresh nodes
+ * and each input node is freed as soon as it has been drained. Equal elements keep their order,
+ * with those of head_1 first.
+ */
+template<typename T, prelude::size_t N, typename Alloc = prelude::node_allocator<unrolled_node<T, N>>>
+unrolled_node<T, N>* merge(unrolled_node<T, N>* head_1, unrolled_node<T, N>* head_2, auto&& pred, Alloc alloc = Alloc()) {
+    unrolled_node<T, N>* result = nullptr;
+    unrolled_node<T, N>* tail = nullptr;
+    prelude::size_t index_1 = 0;
+    prelude::size_t index_2 = 0;
+
+    // Drop drained input nodes; their elements have already been moved out.
+    auto const skip = [&](unrolled_node<T, N>*& head, prelude::size_t& index) {
+        while (head != nullptr && index == head->count) {
+            auto* next = head->next;
+            alloc.deallocate(head, 1);
+            head = next;
+            index = 0;
+        }
+    };
+    auto const take = [&](unrolled_node<T, N>*& head, prelude::size_t& index) {
+        if (tail == nullptr || tail->count == N) {
+            auto* node = prelude::make_unrolled_node<T, N>(alloc, nullptr);
+            (tail == nullptr ? result : tail->next) = node;
+            tail = node;
+        }
+        prelude::relocate(head->data() + index, 1, tail->data() + tail->count);
+        ++tail->count;
+        ++index;
+        skip(head, index);
+    };
+
+    skip(head_1, index_1);
+    skip(head_2, index_2);
     while (head_1 != nullptr && head_2 != nullptr) {
-        if (pred(head_1->data, head_2->data)) {
-            it->next = head_1;
-            if (head_1 != nullptr) {
-                head_1->prev = it;
-            }
-            head_1 = head_1->next;
-            it = head_1;
+        if (pred((*head_2)[index_2], (*head_1)[index_1])) {
+            take(head_2, index_2);
         }
         else {
-            it->next = head_2;
-            if (head_2 != nullptr) {
-                head_2->prev = it;
-            }
-            head_2 = head_2->next;
-            it = head_2;
+            take(head_1, index_1);
         }
     }
-
-    if (head_1 != nullptr) {
-        it->next = head_1;
-        head_1->prev = it;
+    while (head_1 != nullptr) {
+        take(head_1, index_1);
     }
-    else if (head_2 != nullptr) {
-        it->next = head_2;
-        head_2->prev = it;
+    while (head_2 != nullptr) {
+        take(head_2, index_2);
     }
-    return dumb.next;
+    return result;
 }
 
 template<typename T>
@@ -193,6 +416,16 @@ constexpr doubly_linked_node<T>* nth(doubly_linked_node<T>* head, prelude::size_
     return reinterpret_cast<doubly_linked_node<T>*>(nth(reinterpret_cast<singly_linked_node<T>*>(head), n));
 }
 
+// Skips whole nodes by their counts; returns a null node if the list is shorter than n + 1.
+template<typename T, prelude::size_t N>
+constexpr unrolled_position<T, N> nth(unrolled_node<T, N>* head, prelude::size_t n) {
+    while (head != nullptr && n >= head->count) {
+        n -= head->count;
+        head = head->next;
+    }
+    return { head, n };
+}
+
 template<typename T>
 constexpr void remove_after(singly_linked_node<T>* pos) {
     if (pos == nullptr || pos->next == nullptr) {
@@ -212,10 +445,56 @@ constexpr void remove_after(doubly_linked_node<T>* pos) {
     }
 }
 
+/**
+ * @brief Erase the element right after pos, which may be the first one of the next node. A node
+ * left less than half full takes elements from its successor, or absorbs it entirely if they fit
+ * together, and an emptied node is unlinked and freed.
+ */
+template<typename T, prelude::size_t N, typename Alloc = prelude::node_allocator<unrolled_node<T, N>>>
+void remove_after(unrolled_position<T, N> pos, Alloc alloc = Alloc()) {
+    if (pos.node == nullptr) {
+        return;
+    }
+    auto* node = pos.node;
+    auto index = pos.index + 1;
+    if (index == node->count) {
+        node = node->next;
+        index = 0;
+        if (node == nullptr) {
+            return;
+        }
+    }
+    node->data()[index].~T();
+    prelude::relocate(node->data() + index + 1, node->count - index - 1, node->data() + index);
+    --node->count;
+
+    auto* next = node->next;
+    if (node->count == 0) {
+        // Only the successor of pos.node can run dry, since pos itself still lives in pos.node.
+        pos.node->next = next;
+        alloc.deallocate(node, 1);
+    }
+    else if (node->count < N / 2 && next != nullptr) {
+        if (node->count + next->count <= N) {
+            prelude::relocate(next->data(), next->count, node->data() + node->count);
+            node->count += next->count;
+            node->next = next->next;
+            alloc.deallocate(next, 1);
+        }
+        else {
+            auto const borrow = N / 2 - node->count;
+            prelude::relocate(next->data(), borrow, node->data() + node->count);
+            prelude::relocate(next->data() + borrow, next->count - borrow, next->data());
+            node->count += borrow;
+            next->count -= borrow;
+        }
+    }
+}
+
 template<typename T>
-constexpr void reverse(singly_linked_node<T>* head) {
+constexpr singly_linked_node<T>* reverse(singly_linked_node<T>* head) {
     auto* curr = head;
-    auto* prev = nullptr;
+    singly_linked_node<T>* prev = nullptr;
     while (curr != nullptr) {
         auto* tmp = curr->next;
         curr->next = prev;
@@ -226,9 +505,9 @@ constexpr void reverse(singly_linked_node<T>* head) {
 }
 
 template<typename T>
-constexpr void reverse(doubly_linked_node<T>* head) {
+constexpr doubly_linked_node<T>* reverse(doubly_linked_node<T>* head) {
     auto* curr = head;
-    auto* prev = nullptr;
+    doubly_linked_node<T>* prev = nullptr;
     while (curr != nullptr) {
         auto* tmp = curr->next;
         curr->next = prev;
@@ -254,6 +533,16 @@ constexpr prelude::size_t size(doubly_linked_node<T>* head) {
     return size(reinterpret_cast<singly_linked_node<T>*>(head));
 }
 
+template<typename T, prelude::size_t N>
+constexpr prelude::size_t size(unrolled_node<T, N>* head) {
+    auto result = 0uz;
+    while (head != nullptr) {
+        result += head->count;
+        head = head->next;
+    }
+    return result;
+}
+
 template<typename T, prelude::size_t N>
 constexpr prelude::size_t size(tree_node<T, N>* root) {
     if (root == nullptr) {
@@ -266,6 +555,145 @@ constexpr prelude::size_t size(tree_node<T, N>* root) {
     return result + 1;
 }
 
+/**
+ * @brief Detach the maximal sorted run at the front of the chain starting at it, and advance it past
+ * the run. A strictly descending run is reversed on the way, which keeps the sort stable and makes
+ * reverse-sorted input a single run as well.
+ */
+template<typename Node>
+constexpr node_run<Node> take_run(Node*& it, auto& pred) {
+    auto* head = it;
+    auto* tail = head;
+    if (head->next != nullptr && pred(head->next->data, head->data)) {
+        it = head->next;
+        head->next = nullptr;
+        while (it != nullptr && pred(it->data, head->data)) {
+            auto* next = it->next;
+            it->next = head;
+            if constexpr (requires { head->prev; }) {
+                head->prev = it;
+            }
+            head = it;
+            it = next;
+        }
+    }
+    else {
+        while (tail->next != nullptr && !pred(tail->next->data, tail->data)) {
+            tail = tail->next;
+        }
+        it = tail->next;
+        tail->next = nullptr;
+    }
+    if constexpr (requires { head->prev; }) {
+        head->prev = nullptr;
+    }
+    return { head, tail };
+}
+
+/**
+ * @brief Stable in-place natural merge sort, iterative and bottom-up. Sorted runs are taken off the
+ * front of the list one at a time and merged like a binary counter into a fixed table of pending
+ * runs, where slot i holds the merge of 2^i runs. Merges therefore happen while their inputs are
+ * still warm in cache, presorted and reverse-sorted input is a single run and costs one scan, and
+ * the only extra space is the 64-slot table. prev links are kept consistent for doubly linked
+ * nodes. Returns the new head.
+ */
+template<typename Node>
+constexpr Node* sort_runs(Node* head, auto& pred) {
+    node_run<Node> pending[64] = {};
+    auto* it = head;
+    while (it != nullptr) {
+        auto carry = prelude::take_run(it, pred);
+        auto i = 0uz;
+        for (; pending[i].head != nullptr; ++i) {
+            // The pending run holds earlier elements, so it goes first to keep the merge stable.
+            carry = prelude::merge_runs(pending[i].head, pending[i].tail, carry.head, carry.tail, pred);
+            pending[i] = {};
+        }
+        pending[i] = carry;
+    }
+    auto result = node_run<Node> {};
+    for (auto& run : pending) {
+        if (run.head != nullptr) {
+            result = prelude::merge_runs(run.head, run.tail, result.head, result.tail, pred);
+        }
+    }
+    return result.head;
+}
+
+template<typename T>
+constexpr singly_linked_node<T>* sort(singly_linked_node<T>* head, auto&& pred) {
+    return prelude::sort_runs(head, pred);
+}
+
+template<typename T>
+constexpr doubly_linked_node<T>* sort(doubly_linked_node<T>* head, auto&& pred) {
+    return prelude::sort_runs(head, pred);
+}
+
+/**
+ * @brief Sort on several threads: the list is cut into one segment per thread, each segment is
+ * sorted with sort() concurrently, and the sorted segments are combined with the k-way merge. The
+ * result is stable. pred is shared between the threads and must be safe to call concurrently.
+ * Lists too short to be worth splitting are sorted on the calling thread.
+ */
+template<typename Node>
+Node* parallel_sort_runs(Node* head, auto& pred, prelude::size_t threads) {
+    constexpr prelude::size_t min_segment = 1 << 14;
+
+    auto const n = prelude::size(head);
+    if (threads > n / min_segment) {
+        threads = n / min_segment;
+    }
+    if (threads <= 1) {
+        return prelude::sort_runs(head, pred);
+    }
+
+    auto node_alloc = prelude::basic_allocator<Node*>();
+    auto thread_alloc = prelude::basic_allocator<std::thread>();
+    auto* segments = node_alloc.allocate(threads);
+    auto* workers = thread_alloc.allocate(threads - 1);
+
+    auto* it = head;
+    for (prelude::size_t i = 0; i < threads; ++i) {
+        segments[i] = it;
+        auto const length = n / threads + (i < n % threads ? 1 : 0);
+        for (prelude::size_t j = 1; j < length; ++j) {
+            it = it->next;
+        }
+        auto* next = it->next;
+        it->next = nullptr;
+        it = next;
+    }
+    for (prelude::size_t i = 1; i < threads; ++i) {
+        ::new(workers + i - 1) std::thread([&pred, segment = segments + i] {
+            *segment = prelude::sort_runs(*segment, pred);
+        });
+    }
+    segments[0] = prelude::sort_runs(segments[0], pred);
+    for (prelude::size_t i = 0; i + 1 < threads; ++i) {
+        workers[i].join();
+        workers[i].~thread();
+    }
+
+    auto* result = prelude::merge_runs(segments, threads, pred);
+    thread_alloc.deallocate(workers, threads - 1);
+    node_alloc.deallocate(segments, threads);
+    return result;
+}
+
+template<typename T>
+singly_linked_node<T>* parallel_sort(singly_linked_node<T>* head, auto&& pred,
+                                     prelude::size_t threads = std::thread::hardware_concurrency()) {
+    return prelude::parallel_sort_runs(head, pred, threads);
+}
+
+template<typename T>
+doubly_linked_node<T>* parallel_sort(doubly_linked_node<T>* head, auto&& pred,
+                                     prelude::size_t threads = std::thread::hardware_concurrency()) {
+    return prelude::parallel_sort_runs(head, pred, threads);
+}
+
 template<typename T>
 constexpr void splice_after(singly_linked_node<T>* pos, singly_linked_node<T>* head) {
     if (pos == nullptr || head == nullptr) {
@@ -290,4 +718,350 @@ constexpr void splice_after(doubly_linked_node<T>* pos, doubly_linked_node<T>* h
     head->prev = pos;
 }
 
+
+template<typename T, prelude::size_t N>
+constexpr void splice_after(unrolled_node<T, N>* pos, unrolled_node<T, N>* head) {
+    if (pos == nullptr || head == nullptr) {
+        return;
+    }
+    auto* tmp = last(head);
+    tmp->next = pos->next;
+    pos->next = head;
+}
+
+template<typename Node, bool Const>
+class intrusive_list_iterator;
+
+/**
+ * @brief A non-owning handle over a chain of singly_linked_node or doubly_linked_node that caches
+ * its head, tail and length, so that size, back, push_back and splicing one list into another are
+ * O(1) instead of a walk. The nodes belong to the caller: the handle never allocates or frees, it
+ * only relinks what it is given and hands nodes back on removal.
+ *
+ * With doubly linked nodes pop_back and erase of an arbitrary node are O(1) as well.
+ *
+ * @tparam Node singly_linked_node<T> or doubly_linked_node<T>.
+ *
+ * @example Moving nodes between lists without allocating.
+ * @code
+ *      auto ready = intrusive_list<singly_linked_node<task>>();
+ *      ready.push_back(&node);
+ *      pending.splice_back(ready);     // O(1), ready is left empty
+ * @endcode
+ */
+template<typename Node>
+class intrusive_list {
+public:
+    using node_type = Node;
+    using value_type = decltype(Node::data);
+    using size_type = prelude::size_t;
+    using reference_type = value_type&;
+    using const_reference_type = value_type const&;
+    using iterator_type = intrusive_list_iterator<Node, false>;
+    using const_iterator_type = intrusive_list_iterator<Node, true>;
+
+    static constexpr bool k_doubly_linked = requires (Node* node) { node->prev; };
+
+    constexpr intrusive_list() noexcept = default;
+
+    // Adopt an existing null-terminated chain; this walks it once to find the tail and length.
+    constexpr explicit intrusive_list(Node* head) noexcept
+        : m_head(head) {
+
+        for (auto* it = head; it != nullptr; it = it->next) {
+            m_tail = it;
+            ++m_size;
+        }
+    }
+
+    // Two handles over the same chain would fall out of sync, so handles only move.
+    intrusive_list(intrusive_list const&) = delete;
+
+    constexpr intrusive_list(intrusive_list&& other) noexcept
+        : m_head(other.m_head), m_tail(other.m_tail), m_size(other.m_size) {
+
+        other.clear();
+    }
+
+    intrusive_list& operator =(intrusive_list const&) = delete;
+
+    constexpr intrusive_list& operator =(intrusive_list&& other) noexcept {
+        if (this != &other) {
+            m_head = other.m_head;
+            m_tail = other.m_tail;
+            m_size = other.m_size;
+            other.clear();
+        }
+        return *this;
+    }
+
+    constexpr value_type const& back() const {
+        return m_tail->data;
+    }
+
+    constexpr value_type& back() {
+        return m_tail->data;
+    }
+
+    constexpr const_iterator_type begin() const noexcept {
+        return { m_head };
+    }
+
+    constexpr iterator_type begin() noexcept {
+        return { m_head };
+    }
+
+    constexpr const_iterator_type cbegin() const noexcept {
+        return { m_head };
+    }
+
+    constexpr const_iterator_type cend() const noexcept {
+        return {};
+    }
+
+    // Forget every node without touching them.
+    constexpr void clear() noexcept {
+        m_head = nullptr;
+        m_tail = nullptr;
+        m_size = 0;
+    }
+
+    constexpr bool empty() const noexcept {
+        return m_size == 0;
+    }
+
+    constexpr const_iterator_type end() const noexcept {
+        return {};
+    }
+
+    constexpr iterator_type end() noexcept {
+        return {};
+    }
+
+    // Unlink node, which must be in this list, and return it. O(1) with doubly linked nodes.
+    constexpr Node* erase(Node* node) noexcept requires k_doubly_linked {
+        if (node->prev != nullptr) {
+            node->prev->next = node->next;
+        }
+        else {
+            m_head = node->next;
+        }
+        if (node->next != nullptr) {
+            node->next->prev = node->prev;
+        }
+        else {
+            m_tail = node->prev;
+        }
+        --m_size;
+        node->next = nullptr;
+        node->prev = nullptr;
+        return node;
+    }
+
+    constexpr value_type const& front() const {
+        return m_head->data;
+    }
+
+    constexpr value_type& front() {
+        return m_head->data;
+    }
+
+    constexpr Node* head() const noexcept {
+        return m_head;
+    }
+
+    // Link node right after pos, which must be in this list.
+    constexpr void insert_after(Node* pos, Node* node) noexcept {
+        node->next = pos->next;
+        if constexpr (k_doubly_linked) {
+            node->prev = pos;
+            if (pos->next != nullptr) {
+                pos->next->prev = node;
+            }
+        }
+        pos->next = node;
+        if (pos == m_tail) {
+            m_tail = node;
+        }
+        ++m_size;
+    }
+
+    constexpr bool is_empty() const noexcept {
+        return m_size == 0;
+    }
+
+    constexpr Node* pop_back() noexcept requires k_doubly_linked {
+        return this->erase(m_tail);
+    }
+
+    constexpr Node* pop_front() noexcept {
+        auto* node = m_head;
+        m_head = node->next;
+        if (m_head == nullptr) {
+            m_tail = nullptr;
+        }
+        else if constexpr (k_doubly_linked) {
+            m_head->prev = nullptr;
+        }
+        --m_size;
+        node->next = nullptr;
+        return node;
+    }
+
+    constexpr void push_back(Node* node) noexcept {
+        node->next = nullptr;
+        if constexpr (k_doubly_linked) {
+            node->prev = m_tail;
+        }
+        if (m_tail != nullptr) {
+            m_tail->next = node;
+        }
+        else {
+            m_head = node;
+        }
+        m_tail = node;
+        ++m_size;
+    }
+
+    constexpr void push_front(Node* node) noexcept {
+        node->next = m_head;
+        if constexpr (k_doubly_linked) {
+            node->prev = nullptr;
+            if (m_head != nullptr) {
+                m_head->prev = node;
+            }
+        }
+        if (m_head == nullptr) {
+            m_tail = node;
+        }
+        m_head = node;
+        ++m_size;
+    }
+
+    // Hand the chain back to the caller and leave the handle empty.
+    constexpr Node* release() noexcept {
+        auto* head = m_head;
+        this->clear();
+        return head;
+    }
+
+    // Unlink the node after pos and return it, or nullptr if pos is the tail.
+    constexpr Node* remove_after(Node* pos) noexcept {
+        auto* node = pos->next;
+        if (node == nullptr) {
+            return nullptr;
+        }
+        pos->next = node->next;
+        if constexpr (k_doubly_linked) {
+            if (node->next != nullptr) {
+                node->next->prev = pos;
+            }
+        }
+        if (node == m_tail) {
+            m_tail = pos;
+        }
+        --m_size;
+        node->next = nullptr;
+        return node;
+    }
+
+    constexpr size_type size() const noexcept {
+        return m_size;
+    }
+
+    // Move every node of other to the end of this list in O(1).
+    constexpr void splice_back(intrusive_list& other) noexcept {
+        if (m_tail == nullptr) {
+            *this = static_cast<intrusive_list&&>(other);
+            return;
+        }
+        this->splice_after(m_tail, other);
+    }
+
+    // Move every node of other right after pos, which must be in this list, in O(1).
+    constexpr void splice_after(Node* pos, intrusive_list& other) noexcept {
+        if (other.m_head == nullptr) {
+            return;
+        }
+        other.m_tail->next = pos->next;
+        if constexpr (k_doubly_linked) {
+            other.m_head->prev = pos;
+            if (pos->next != nullptr) {
+                pos->next->prev = other.m_tail;
+            }
+        }
+        pos->next = other.m_head;
+        if (pos == m_tail) {
+            m_tail = other.m_tail;
+        }
+        m_size += other.m_size;
+        other.clear();
+    }
+
+    constexpr Node* tail() const noexcept {
+        return m_tail;
+    }
+
+    friend constexpr void swap(intrusive_list& lhs, intrusive_list& rhs) noexcept {
+        std::swap(lhs.m_head, rhs.m_head);
+        std::swap(lhs.m_tail, rhs.m_tail);
+        std::swap(lhs.m_size, rhs.m_size);
+    }
+
+private:
+    Node* m_head = nullptr;
+    Node* m_tail = nullptr;
+    size_type m_size = 0;
+};
+
+template<typename Node, bool Const>
+class intrusive_list_iterator {
+public:
+    using value_type = decltype(Node::data);
+    using size_type = prelude::size_t;
+    using difference_type = prelude::ssize_t;
+    using node_pointer_type = std::conditional_t<Const, Node const*, Node*>;
+    using pointer_type = std::conditional_t<Const, value_type const*, value_type*>;
+    using const_pointer_type = value_type const*;
+    using reference_type = std::conditional_t<Const, value_type const&, value_type&>;
+    using const_reference_type = value_type const&;
+
+    constexpr intrusive_list_iterator() noexcept = default;
+
+    constexpr intrusive_list_iterator(node_pointer_type node) noexcept
+        : m_node(node) {}
+
+    constexpr operator intrusive_list_iterator<Node, true>() const noexcept {
+        return { m_node };
+    }
+
+    constexpr node_pointer_type node() const noexcept {
+        return m_node;
+    }
+
+    constexpr reference_type operator *() const {
+        return m_node->data;
+    }
+
+    constexpr pointer_type operator ->() const {
+        return &m_node->data;
+    }
+
+    constexpr intrusive_list_iterator& operator ++() noexcept {
+        m_node = m_node->next;
+        return *this;
+    }
+
+    constexpr intrusive_list_iterator operator ++(int) noexcept {
+        auto ret = *this;
+        m_node = m_node->next;
+        return ret;
+    }
+
+    constexpr bool operator ==(intrusive_list_iterator const& other) const noexcept = default;
+
+private:
+    node_pointer_type m_node = nullptr;
+};
+
 } // namespace prelude
\ No newline at end of file
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <atomic>
+#include <initializer_list>
+#include <utility>
+
+#include "../defs.hpp"
+#include "../utils/allocator.hpp"
+
+namespace prelude {
+
+template<typename T>
+struct persistent_cons_cell {
+    T head;
+    persistent_cons_cell* tail;
+    std::atomic<prelude::size_t> refs;
+};
+
+template<typename T>
+class persistent_cons_iterator;
+
+/**
+ * @brief An immutable singly linked list whose cells are shared between versions and freed when the
+ * last version referencing them goes away. Every operation that makes a "new" list links onto the
+ * cells of the old one instead of copying them, so thousands of versions with a common suffix cost
+ * one cell per element that actually differs.
+ *
+ * prepend, tail and copying a list are O(1); drop(n) follows n links but copies nothing; concat
+ * copies the left list's cells and shares the right list entirely. Cells are reference counted
+ * atomically, so versions may be handed to and dropped on other threads.
+ *
+ * @tparam T The element type.
+ * @tparam Alloc The allocator for cells.
+ *
+ * @example Keeping a rollback point.
+ * @code
+ *      auto history = persistent_cons<int>::from_list({ 3, 4 });
+ *      auto snapshot = history;            // shares every cell
+ *      history = history.prepend(2);       // snapshot is still { 3, 4 }
+ * @endcode
+ */
+template<typename T, typename Alloc = prelude::node_allocator<persistent_cons_cell<T>>>
+class persistent_cons {
+public:
+    using value_type = T;
+    using size_type = prelude::size_t;
+    using cell_type = persistent_cons_cell<T>;
+    using const_reference_type = T const&;
+    using iterator_type = persistent_cons_iterator<T>;
+    using const_iterator_type = persistent_cons_iterator<T>;
+
+    constexpr persistent_cons() noexcept = default;
+
+    persistent_cons(T head, persistent_cons const& tail)
+        : m_alloc(tail.m_alloc) {
+
+        m_cell = this->make_cell(static_cast<T&&>(head), persistent_cons::retain(tail.m_cell));
+    }
+
+    persistent_cons(persistent_cons const& other) noexcept
+        : m_cell(persistent_cons::retain(other.m_cell)), m_alloc(other.m_alloc) {}
+
+    persistent_cons(persistent_cons&& other) noexcept
+        : m_cell(other.m_cell), m_alloc(static_cast<Alloc&&>(other.m_alloc)) {
+
+        other.m_cell = nullptr;
+    }
+
+    ~persistent_cons() {
+        this->release(m_cell);
+    }
+
+    persistent_cons& operator =(persistent_cons const& other) {
+        auto tmp = other;
+        swap(*this, tmp);
+        return *this;
+    }
+
+    persistent_cons& operator =(persistent_cons&& other) noexcept {
+        auto tmp = static_cast<persistent_cons&&>(other);
+        swap(*this, tmp);
+        return *this;
+    }
+
+    static persistent_cons from_list(std::initializer_list<T> const& list) {
+        return persistent_cons::from_range(list.begin(), list.end());
+    }
+
+    // Builds front to back, so the input only has to be traversed once.
+    template<typename InIt>
+    static persistent_cons from_range(InIt first, InIt last) {
+        auto result = persistent_cons();
+        auto** link = &result.m_cell;
+        while (first != last) {
+            *link = result.make_cell(*first, nullptr);
+            link = &(*link)->tail;
+            ++first;
+        }
+        return result;
+    }
+
+    constexpr const_iterator_type begin() const noexcept {
+        return { m_cell };
+    }
+
+    constexpr const_iterator_type cbegin() const noexcept {
+        return { m_cell };
+    }
+
+    constexpr const_iterator_type cend() const noexcept {
+        return {};
+    }
+
+    /**
+     * @brief This list followed by other. Only this list's cells are copied; the result links onto
+     * other's cells directly.
+     */
+    persistent_cons concat(persistent_cons const& other) const {
+        if (m_cell == nullptr) {
+            return other;
+        }
+        auto result = persistent_cons();
+        result.m_alloc = m_alloc;
+        auto** link = &result.m_cell;
+        for (auto* it = m_cell; it != nullptr; it = it->tail) {
+            *link = result.make_cell(it->head, nullptr);
+            link = &(*link)->tail;
+        }
+        *link = persistent_cons::retain(other.m_cell);
+        return result;
+    }
+
+    // The list without its first n elements, sharing its cells. Follows n links.
+    persistent_cons drop(size_type n) const {
+        auto* it = m_cell;
+        while (n-- > 0 && it != nullptr) {
+            it = it->tail;
+        }
+        return { persistent_cons::retain(it), m_alloc };
+    }
+
+    constexpr bool empty() const noexcept {
+        return m_cell == nullptr;
+    }
+
+    constexpr const_iterator_type end() const noexcept {
+        return {};
+    }
+
+    constexpr T const& front() const noexcept {
+        return m_cell->head;
+    }
+
+    constexpr T const& head() const noexcept {
+        return m_cell->head;
+    }
+
+    constexpr bool is_empty() const noexcept {
+        return m_cell == nullptr;
+    }
+
+    // A new list with value in front of this one. This list is unaffected.
+    persistent_cons prepend(T value) const {
+        return { static_cast<T&&>(value), *this };
+    }
+
+    size_type size() const noexcept {
+        auto result = 0uz;
+        for (auto* it = m_cell; it != nullptr; it = it->tail) {
+            ++result;
+        }
+        return result;
+    }
+
+    // The list without its first element, sharing its cells.
+    persistent_cons tail() const noexcept {
+        return { persistent_cons::retain(m_cell->tail), m_alloc };
+    }
+
+    // How many lists and cells refer to the first cell; 0 for the empty list.
+    size_type use_count() const noexcept {
+        return m_cell == nullptr ? 0 : m_cell->refs.load(std::memory_order_relaxed);
+    }
+
+    T const& operator [](size_type i) const {
+        auto* it = m_cell;
+        while (i-- > 0) {
+            it = it->tail;
+        }
+        return it->head;
+    }
+
+    friend void swap(persistent_cons& lhs, persistent_cons& rhs) noexcept {
+        std::swap(lhs.m_cell, rhs.m_cell);
+        std::swap(lhs.m_alloc, rhs.m_alloc);
+    }
+
+private:
+    // Adopts a reference the caller already holds.
+    persistent_cons(cell_type* cell, Alloc const& alloc) noexcept
+        : m_cell(cell), m_alloc(alloc) {}
+
+    static cell_type* retain(cell_type* cell) noexcept {
+        if (cell != nullptr) {
+            cell->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        return cell;
+    }
+
+    // Takes ownership of the reference to tail.
+    cell_type* make_cell(T head, cell_type* tail) {
+        auto* cell = m_alloc.allocate(1);
+        return ::new(cell) cell_type { static_cast<T&&>(head), tail, 1 };
+    }
+
+    // Drop a reference and free every cell that was kept alive only by it. This is a loop rather
+    // than a recursion so that releasing a long unshared list cannot overflow the stack.
+    void release(cell_type* cell) noexcept {
+        while (cell != nullptr && cell->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            auto* tail = cell->tail;
+            cell->~cell_type();
+            m_alloc.deallocate(cell, 1);
+            cell = tail;
+        }
+    }
+
+    cell_type* m_cell = nullptr;
+    [[no_unique_address]] Alloc m_alloc = {};
+};
+
+template<typename T>
+class persistent_cons_iterator {
+public:
+    using value_type = T;
+    using size_type = prelude::size_t;
+    using difference_type = prelude::ssize_t;
+    using pointer_type = T const*;
+    using const_pointer_type = T const*;
+    using reference_type = T const&;
+    using const_reference_type = T const&;
+
+    constexpr persistent_cons_iterator() noexcept = default;
+
+    constexpr persistent_cons_iterator(persistent_cons_cell<T> const* cell) noexcept
+        : m_cell(cell) {}
+
+    constexpr T const& operator *() const {
+        return m_cell->head;
+    }
+
+    constexpr T const* operator ->() const {
+        return &m_cell->head;
+    }
+
+    constexpr persistent_cons_iterator& operator ++() noexcept {
+        m_cell = m_cell->tail;
+        return *this;
+    }
+
+    constexpr persistent_cons_iterator operator ++(int) noexcept {
+        auto ret = *this;
+        m_cell = m_cell->tail;
+        return ret;
+    }
+
+    constexpr bool operator ==(persistent_cons_iterator const& other) const noexcept = default;
+
+private:
+    persistent_cons_cell<T> const* m_cell = nullptr;
+};
+
+} // namespace prelude
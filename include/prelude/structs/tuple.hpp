@@ -1,10 +1,11 @@
 #pragma once
 
+#include <type_traits>
 #include <utility>
 
 #include "../defs.hpp"
 #include "../utils/general.hpp"
-#include "../utils/meta.hpp"
+#include "../utils/type_list.hpp"
 
 namespace prelude {
 
@@ -29,8 +30,11 @@ consteval auto operator ""_idx();
 
 template<typename T, prelude::size_t I>
 struct tuple_element_wrapper {
+    constexpr tuple_element_wrapper()
+        : m_value() {}
+
     template<typename U>
-    tuple_element_wrapper(U&& val)
+    constexpr tuple_element_wrapper(U&& val)
         : m_value(prelude::forward<U>(val)) {}
 
     T const& get() const noexcept {
@@ -67,7 +71,9 @@ struct tuple<Head, Tail...> : tuple_element_wrapper<Head, sizeof...(Tail)>, tupl
 
     constexpr tuple() = default;
 
+    // One argument per element; a lone tuple argument is a copy or move, not an element.
     template<typename Head_, typename... Tail_>
+        requires (sizeof...(Tail_) == sizeof...(Tail) && !std::is_same_v<std::remove_cvref_t<Head_>, tuple>)
     constexpr tuple(Head_&& head, Tail_&&... tail)
         : head_element_type(prelude::forward<Head_>(head)),
           tail_type(prelude::forward<Tail_>(tail)...) {}
@@ -96,7 +102,7 @@ struct tuple<Head, Tail...> : tuple_element_wrapper<Head, sizeof...(Tail)>, tupl
      * @endcode
      */
     template<prelude::size_t I>
-    constexpr auto operator [](constexpr_size<I>);
+    constexpr decltype(auto) operator [](constexpr_size<I>);
 
     constexpr tail_type const& tail() const noexcept {
         return *this;
@@ -107,29 +113,29 @@ struct tuple<Head, Tail...> : tuple_element_wrapper<Head, sizeof...(Tail)>, tupl
     }
 };
 
-// Support for structured bindings
-template<typename... Ts>
-struct std::tuple_size<tuple<Ts...>> : std::integeral_constant<prelude::size_t, sizeof...(Ts)> {};
-
-template<typename... Ts, prelude::size_t I>
-struct std::tuple_element<I, tuple<Ts...>> {
-    static_assert(I < sizeof...(Ts), "Index out of bound");
-    using type = std::tuple_element_t<I, tuple<Ts...>>;
-};
-
 template<prelude::size_t I, typename T>
 constexpr T& get_element(tuple_element_wrapper<T, I>& te) {
     return te.get();
 }
 
+template<prelude::size_t I, typename T>
+constexpr T const& get_element(tuple_element_wrapper<T, I> const& te) {
+    return te.get();
+}
+
+template<prelude::size_t I, typename... Ts>
+constexpr decltype(auto) get(tuple<Ts...>& tup) {
+    return get_element<sizeof...(Ts) - I - 1>(tup);
+}
+
 template<prelude::size_t I, typename... Ts>
-constexpr auto get(tuple<Ts...>& tup) {
+constexpr decltype(auto) get(tuple<Ts...> const& tup) {
     return get_element<sizeof...(Ts) - I - 1>(tup);
 }
 
 template<typename Head, typename... Tail>
 template<prelude::size_t I>
-constexpr auto tuple<Head, Tail...>::operator [](constexpr_size<I>) {
+constexpr decltype(auto) tuple<Head, Tail...>::operator [](constexpr_size<I>) {
     return get<I>(*this);
 }
 
@@ -139,6 +145,14 @@ consteval auto operator ""_idx() {
     return constexpr_size<const_value<prelude::size_t>(arr)>();
 }
 
+} // namespace prelude
 
+// Support for structured bindings
+template<typename... Ts>
+struct std::tuple_size<prelude::tuple<Ts...>> : std::integral_constant<std::size_t, sizeof...(Ts)> {};
 
-} // namespace prelude
\ No newline at end of file
+template<std::size_t I, typename... Ts>
+struct std::tuple_element<I, prelude::tuple<Ts...>> {
+    static_assert(I < sizeof...(Ts), "Index out of bound");
+    using type = prelude::typeof<prelude::type_nth<I, prelude::type_list<Ts...>>>;
+};
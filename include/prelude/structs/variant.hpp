@@ -1,6 +1,13 @@
 #pragma once
 
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <type_traits>
+#include <utility>
+
 #include "../defs.hpp"
+#include "../utils/general.hpp"
 #include "../utils/type_list.hpp"
 
 namespace prelude {
@@ -8,211 +15,491 @@ namespace prelude {
 template<typename... Ts>
 struct variant;
 
-template<typename T, typename... Ts>
-struct variant_element_wrapper;
-
 template<typename... Ts>
 struct variant_storage;
 
 template<typename... Fs>
 struct variant_visitor;
 
+struct variant_access;
+
+template<typename F, typename... Vs>
+decltype(auto) visit(F&& f, Vs&&... vars);
+
+struct bad_variant_access : std::exception {
+    char const* what() const noexcept override {
+        return "bad variant access";
+    }
+};
+
+// Dispatch
+
+// Up to this many cases dispatch() is a switch; above it, a table of function pointers.
+inline constexpr prelude::size_t k_dispatch_switch_max = 8;
+
+template<typename R, typename F, typename Seq>
+struct dispatch_table;
+
+template<typename R, typename F, prelude::size_t... I>
+struct dispatch_table<R, F, std::integer_sequence<prelude::size_t, I...>> {
+    template<prelude::size_t J>
+    static constexpr R entry(F&& f) {
+        return static_cast<F&&>(f)(constexpr_size<J>());
+    }
+
+    static constexpr R (*k_entries[])(F&&) = { &dispatch_table::entry<I>... };
+};
+
+/**
+ * @brief Call f(constexpr_size<I>()) with I equal to the runtime index i, which must be less than
+ * N, in constant time. Small N compile to a switch, which the compiler lowers to a jump table or a
+ * few compares as it sees fit; larger N index a table of function pointers generated at compile
+ * time. Either way the cases are never tried one after another.
+ *
+ * Every instantiation of f must return the same type.
+ *
+ * @example
+ * @code
+ *      dispatch<3>(i, [&]<prelude::size_t I>(constexpr_size<I>) { return sizeof(nth_type<I>); });
+ * @endcode
+ */
+template<prelude::size_t N, typename F>
+constexpr auto dispatch(prelude::size_t i, F&& f) -> decltype(static_cast<F&&>(f)(constexpr_size<0>())) {
+    static_assert(N > 0, "Nothing to dispatch to");
+    using result_type = decltype(static_cast<F&&>(f)(constexpr_size<0>()));
+    if constexpr (N <= k_dispatch_switch_max) {
+        // Cases past N are discarded at compile time and fall through to the unreachable default.
+        switch (i) {
+        case 0:
+            return static_cast<F&&>(f)(constexpr_size<0>());
+        case 1:
+            if constexpr (N > 1) {
+                return static_cast<F&&>(f)(constexpr_size<1>());
+            }
+            [[fallthrough]];
+        case 2:
+            if constexpr (N > 2) {
+                return static_cast<F&&>(f)(constexpr_size<2>());
+            }
+            [[fallthrough]];
+        case 3:
+            if constexpr (N > 3) {
+                return static_cast<F&&>(f)(constexpr_size<3>());
+            }
+            [[fallthrough]];
+        case 4:
+            if constexpr (N > 4) {
+                return static_cast<F&&>(f)(constexpr_size<4>());
+            }
+            [[fallthrough]];
+        case 5:
+            if constexpr (N > 5) {
+                return static_cast<F&&>(f)(constexpr_size<5>());
+            }
+            [[fallthrough]];
+        case 6:
+            if constexpr (N > 6) {
+                return static_cast<F&&>(f)(constexpr_size<6>());
+            }
+            [[fallthrough]];
+        case 7:
+            if constexpr (N > 7) {
+                return static_cast<F&&>(f)(constexpr_size<7>());
+            }
+            [[fallthrough]];
+        default:
+            std::unreachable();
+        }
+    }
+    else {
+        using table_type = dispatch_table<result_type, F, std::make_integer_sequence<prelude::size_t, N>>;
+        return table_type::k_entries[i](static_cast<F&&>(f));
+    }
+}
+
+// A mixed radix with digits less than Ns..., most significant first.
+template<prelude::size_t... Ns>
+struct dispatch_radix {
+    static constexpr prelude::size_t k_radices[] = { Ns... };
+
+    static consteval prelude::size_t digit(prelude::size_t flat, prelude::size_t k) {
+        prelude::size_t stride = 1;
+        for (auto j = sizeof...(Ns); j-- > k + 1;) {
+            stride *= k_radices[j];
+        }
+        return flat / stride % k_radices[k];
+    }
+};
+
+/**
+ * @brief Call f(constexpr_size<I0>(), constexpr_size<I1>(), ...) for several runtime indices at
+ * once, where index k is less than the k-th of Ns. The indices are flattened into one, so this is
+ * a single dispatch() over a table of N0 * N1 * ... entries rather than nested dispatches.
+ */
+template<prelude::size_t... Ns, typename F, typename... Is>
+constexpr decltype(auto) dispatch_flat(F&& f, Is... indices) {
+    static_assert(sizeof...(Ns) == sizeof...(Is), "One index per dimension");
+    using radix = dispatch_radix<Ns...>;
+    auto flat = prelude::size_t(0);
+    ((flat = flat * Ns + static_cast<prelude::size_t>(indices)), ...);
+    return prelude::dispatch<(Ns * ... * 1)>(flat, [&]<prelude::size_t J>(constexpr_size<J>) -> decltype(auto) {
+        return [&]<prelude::size_t... K>(std::integer_sequence<prelude::size_t, K...>) -> decltype(auto) {
+            return static_cast<F&&>(f)(constexpr_size<radix::digit(J, K)>()...);
+        }(std::make_integer_sequence<prelude::size_t, sizeof...(Ns)>());
+    });
+}
+
+// Variant
 
 template<typename... Ts>
 struct variant_storage {
     static constexpr prelude::size_t k_max_size = max_element<type_list<Ts...>>::value;
 
-    // The index is 0 when the variant is empty.
-    // So index is actually 1-indexed.
-    unsigned char index = 0;
+    // Wide enough for every alternative plus the empty state, and no wider.
+    using index_type = std::conditional_t<(sizeof...(Ts) < UINT8_MAX), std::uint8_t,
+                       std::conditional_t<(sizeof...(Ts) < UINT16_MAX), std::uint16_t, std::uint32_t>>;
 
-    constexpr void const* data() const noexcept {
+    void const* data() const noexcept {
         return m_data;
     }
 
-    constexpr void* data() noexcept {
+    void* data() noexcept {
         return m_data;
     }
 
     template<typename T>
-    constexpr T const* data_as() const noexcept {
+    T const* data_as() const noexcept {
         return std::launder(reinterpret_cast<T const*>(m_data));
     }
 
     template<typename T>
-    constexpr T* data_as() noexcept {
+    T* data_as() noexcept {
         return std::launder(reinterpret_cast<T*>(m_data));
     }
 
 private:
     // Make sure the size of the variant is at least the size of the largest variant element.
     alignas(Ts...) unsigned char m_data[k_max_size];
+
+public:
+    // The index is 0 when the variant is empty.
+    // So index is actually 1-indexed.
+    // It follows the data so that it fills the padding after the largest element when there is
+    // some, e.g. variant<int, char[5]> takes 8 bytes rather than 12.
+    index_type index = 0;
 };
 
-template<typename T, typename... Ts>
-struct variant_element_wrapper {
-    using value_type = T;
-    using derived_type = variant<Ts...>;
+/**
+ * @brief An overload set built from several callables, for visiting a variant with one lambda per
+ * alternative.
+ *
+ * @example
+ * @code
+ *      var.visit([](int i) { ... }, [](std::string const& s) { ... });
+ * @endcode
+ */
+template<typename... Fs>
+struct variant_visitor : Fs... {
+    using Fs::operator ()...;
 
-    constexpr static prelude::size_t k_index = prelude::find<T, type_list<Ts...>>::value + 1;
+    constexpr variant_visitor(Fs... fs)
+        : Fs(static_cast<Fs&&>(fs))... {}
+};
 
-    constexpr variant_element_wrapper() = default;
+template<typename... Fs>
+variant_visitor(Fs...) -> variant_visitor<Fs...>;
 
-    constexpr variant_element_wrapper(T const& val) {
-        auto& derived = this->as_derived();
-        new (derived.data()) T(val);
-        derived.index = k_index;
+// Unchecked access to the alternatives, for visit() and the variant internals.
+struct variant_access {
+    template<prelude::size_t I, typename V>
+    static decltype(auto) get(V&& var) noexcept {
+        return static_cast<V&&>(var).template unchecked<I>();
     }
+};
 
-    constexpr variant_element_wrapper(T&& val) {
-        auto& derived = this->as_derived();
-        new (derived.data()) T(prelude::move(val));
-        derived.index = k_index;
-    }
+/**
+ * @brief A tagged union of Ts..., or empty. Copying, moving, destroying and visiting all dispatch on
+ * the stored index through dispatch(), so each costs one indirect jump at most, whatever the
+ * number of alternatives.
+ *
+ * The variant is empty when default constructed, after destroy(), and when constructing a new
+ * alternative throws halfway through an assignment.
+ *
+ * When every alternative is trivially copyable, so is the variant: copies are plain byte copies and
+ * arrays of variants can be memcpy'd. Likewise for trivial destruction.
+ *
+ * The alternatives live in a byte buffer, so that the index can share its tail padding, and are
+ * reached through reinterpret_cast. A variant holding a value therefore cannot be built or read in
+ * a constant expression, and only the index queries are constexpr.
+ *
+ * @tparam Ts The alternatives, which must be distinct.
+ */
+template<typename... Ts>
+struct variant : private variant_storage<Ts...> {
+    using storage_type = variant_storage<Ts...>;
+    using types = type_list<Ts...>;
+    using size_type = prelude::size_t;
 
-    constexpr derived_type const& as_derived() const noexcept {
-        return static_cast<derived_type const&>(*this);
-    }
+    static constexpr size_type k_size = sizeof...(Ts);
+    static constexpr size_type k_npos = static_cast<size_type>(-1);
 
-    constexpr derived_type& as_derived() noexcept {
-        return static_cast<derived_type&>(*this);
-    }
+    template<typename T>
+    static constexpr bool k_holds = contains<std::remove_cvref_t<T>, types>::value;
 
-    constexpr derived_type& operator =(T const& val) {
-        auto& derived = this->as_derived();
-        if (derived.index == k_index) {
-            *derived.data_as<T>() = val;
-        }
-        else {
-            derived.destroy();
-            new (derived.data()) T(val);
-            derived.index = k_index;
-        }
-        return derived;
-    }
+    template<typename T>
+    static constexpr size_type k_index_of = find<std::remove_cvref_t<T>, types>::value;
 
-    constexpr derived_type& operator =(T&& val) {
-        auto& derived = this->as_derived();
-        if (derived.index == k_index) {
-            *derived.data_as<T>() = val;
-        }
-        else {
-            derived.destroy();
-            new (derived.data()) T(prelude::move(val));
-            derived.index = k_index;
-        }
-        return derived;       
-    }
+    template<size_type I>
+    using alternative_type = typeof<type_nth<I, types>>;
 
-    constexpr bool try_destroy() {
-        auto& derived = this->as_derived();
-        if (derived.index == k_index) {
-            derived.index = 0;
-            derived.data_as<T>()->~T();
-            return true;
-        }
-        return false;
+    constexpr variant() noexcept = default;
+
+    template<typename U>
+        requires k_holds<U>
+    variant(U&& val) {
+        this->template construct<k_index_of<U>>(static_cast<U&&>(val));
     }
 
-};
+    // Arrays are never copy constructible, so their elements decide.
+    constexpr variant(variant const& other) requires (std::is_trivially_copy_constructible_v<std::remove_all_extents_t<Ts>> && ...) = default;
 
-template<typename... Fs>
-struct variant_visitor : private Fs... {
-    using Fs::operator ()...;
+    variant(variant const& other) {
+        this->construct_from(other);
+    }
 
-    template<typeanme T>
-    struct result_type_aux;
+    constexpr variant(variant&& other) requires (std::is_trivially_move_constructible_v<std::remove_all_extents_t<Ts>> && ...) = default;
 
-    template<typename... Ts, typename Test = void>
-    using result_type = type_list<result_type_aux<Ts>::type...>;
+    variant(variant&& other) noexcept((std::is_nothrow_move_constructible_v<Ts> && ...)) {
+        this->construct_from(static_cast<variant&&>(other));
+    }
 
-    variant_visitor(Fs&&... fs)
-        : Fs(prelude::move(fs))... {}
+    // Converts from a variant whose alternatives are a subset of these.
+    template<typename... Us>
+        requires (!std::is_same_v<variant<Us...>, variant> && (k_holds<Us> && ...))
+    explicit variant(variant<Us...> const& other) {
+        this->construct_from(other);
+    }
+
+    template<typename... Us>
+        requires (!std::is_same_v<variant<Us...>, variant> && (k_holds<Us> && ...))
+    explicit variant(variant<Us...>&& other) {
+        this->construct_from(static_cast<variant<Us...>&&>(other));
+    }
 
-    template<typename... Ts>
-    result_type<Ts...>::type operator ()(variant<Ts...>& var) const {
+    constexpr ~variant() requires (std::is_trivially_destructible_v<Ts> && ...) = default;
 
+    ~variant() {
+        this->destroy();
     }
-};
 
-template<>
-template<typename T>
-struct variant_visitor<>::result_type_aux<T> : type<null> {};
+    constexpr variant& operator =(variant const& other) requires (std::is_trivially_copyable_v<Ts> && ...) = default;
 
-template<typename F, typename... Fs>
-template<typename T>
-struct variant_visitor<F, Fs...>::result_type_aux<T, prelude::void_t<decltype(prelude::declval<F>(std::declval<T>()))>> 
-    : type<decltype(prelude::declval<F>(std::declval<T>()))> {};
+    variant& operator =(variant const& other) {
+        if (this != &other) {
+            this->assign_from(other);
+        }
+        return *this;
+    }
 
-template<typename F, typename... Fs>
-template<typename T>
-struct variant_visitor<F, Fs...>::result_type_aux<T> : variant_visitor<Fs...>::result_type_aux<T> {};
+    constexpr variant& operator =(variant&& other) requires (std::is_trivially_copyable_v<Ts> && ...) = default;
 
-template<typename... Ts>
-struct variant : private variant_storage<Ts...>, private variant_element_wrapper<Ts, Ts...>... {
-    template<typename U, typename... Us>
-    friend struct variant_wrapper;
+    variant& operator =(variant&& other) noexcept((std::is_nothrow_move_constructible_v<Ts> && ...)
+                                                           && (std::is_nothrow_move_assignable_v<Ts> && ...)) {
+        if (this != &other) {
+            this->assign_from(static_cast<variant&&>(other));
+        }
+        return *this;
+    }
 
-    using storage_type = variant_storage<Ts...>;
-    using element_type = variant_element_wrapper<Ts, Ts...>;
+    template<typename U>
+        requires k_holds<U>
+    variant& operator =(U&& val) {
+        constexpr auto i = k_index_of<U>;
+        if (this->storage_type::index == i + 1) {
+            this->template unchecked<i>() = static_cast<U&&>(val);
+        }
+        else {
+            this->destroy();
+            this->template construct<i>(static_cast<U&&>(val));
+        }
+        return *this;
+    }
 
-    using variant_element_wrapper<Ts, Ts...>::variant_element_wrapper...;
-    using variant_element_wrapper<Ts, Ts...>::operator =...;
+    // Destroy the current alternative, if any, and leave the variant empty.
+    void destroy() noexcept {
+        if constexpr ((std::is_trivially_destructible_v<Ts> && ...)) {
+            this->storage_type::index = 0;
+            return;
+        }
+        this->raw_dispatch([&]<size_type I>(constexpr_size<I>) {
+            if constexpr (I != 0) {
+                using T = alternative_type<I - 1>;
+                this->template data_as<T>()->~T();
+            }
+        });
+        this->storage_type::index = 0;
+    }
 
-    constexpr variant();
+    template<typename T, typename... Args>
+        requires k_holds<T>
+    T& emplace(Args&&... args) {
+        this->destroy();
+        this->template construct<k_index_of<T>>(static_cast<Args&&>(args)...);
+        return this->template unchecked<k_index_of<T>>();
+    }
 
-    constexpr explicit variant(variant const& other);
+    template<typename T>
+    T const& get() const& {
+        if (!this->is<T>()) {
+            throw bad_variant_access();
+        }
+        return *this->template data_as<T>();
+    }
 
-    constexpr explicit variant(variant&& other);
+    template<typename T>
+    T& get() & {
+        if (!this->is<T>()) {
+            throw bad_variant_access();
+        }
+        return *this->template data_as<T>();
+    }
 
-    template<typename... Us>
-    constexpr explicit variant(variant<Us...> const& other);
+    template<typename T>
+    T&& get() && {
+        if (!this->is<T>()) {
+            throw bad_variant_access();
+        }
+        return static_cast<T&&>(*this->template data_as<T>());
+    }
 
-    template<typename... Us>
-    constexpr explicit variant(variant<Us...>&& other);
+    // The alternative if it is T, or nullptr.
+    template<typename T>
+    T const* get_if() const noexcept {
+        return this->is<T>() ? this->template data_as<T>() : nullptr;
+    }
 
-    constexpr ~variant() {
-        this->destroy();
+    template<typename T>
+    T* get_if() noexcept {
+        return this->is<T>() ? this->template data_as<T>() : nullptr;
     }
 
-    void destroy() {
-        (this->element_type<Ts, Ts...>::try_destroy(), ...);
+    // The position of the current alternative in Ts, or k_npos when empty.
+    constexpr size_type index() const noexcept {
+        return static_cast<size_type>(this->storage_type::index) - 1;
     }
 
     template<typename T>
-    constexpr T const& get() const& {
-        if (this->is_empty()) {
-            throw 42;
+    constexpr bool is() const noexcept {
+        if constexpr (k_holds<T>) {
+            return this->storage_type::index == k_index_of<T> + 1;
         }
-        else if (!this->is<T>()) {
-            throw 42;
+        else {
+            return false;
         }
-        return *this->template data_as<T>();
     }
 
-    template<typename T>
-    constexpr bool is() const {
-        return static_cast<storage_type&>(*this).index == variant_element_wrapper<T, Ts...>::k_index;
+    constexpr bool is_empty() const noexcept {
+        return this->storage_type::index == 0;
     }
 
-    constexpr bool is_empty() const noexcept;
+    // Call the overload set of fs with the current alternative. Throws if the variant is empty.
+    template<typename... Fs>
+    decltype(auto) visit(Fs&&... fs) const& {
+        return prelude::visit(variant_visitor(static_cast<Fs&&>(fs)...), *this);
+    }
 
-    constexpr variant& operator =(variant const& other);
+    template<typename... Fs>
+    decltype(auto) visit(Fs&&... fs) & {
+        return prelude::visit(variant_visitor(static_cast<Fs&&>(fs)...), *this);
+    }
 
-    constexpr variant& operator =(variant&& other);
+    template<typename... Fs>
+    decltype(auto) visit(Fs&&... fs) && {
+        return prelude::visit(variant_visitor(static_cast<Fs&&>(fs)...), static_cast<variant&&>(*this));
+    }
 
+private:
     template<typename... Us>
-    constexpr variant& operator =(variant<Us...> const& other);
+    friend struct variant;
 
-    template<typename... Us>
-    constexpr variant& operator =(variant<Us...>&& other);
+    friend struct variant_access;
 
-    template<typename... Fs>
-    auto visit(Fs&&... fs) & {
-        return variant_visitor(prelude::forward<Fs>(fs)...);
+    template<size_type I>
+    alternative_type<I> const& unchecked() const& noexcept {
+        return *this->template data_as<alternative_type<I>>();
+    }
+
+    template<size_type I>
+    alternative_type<I>& unchecked() & noexcept {
+        return *this->template data_as<alternative_type<I>>();
+    }
+
+    template<size_type I>
+    alternative_type<I>&& unchecked() && noexcept {
+        return static_cast<alternative_type<I>&&>(*this->template data_as<alternative_type<I>>());
+    }
+
+    // Dispatch on the stored index itself, where 0 is the empty state.
+    template<typename F>
+    constexpr decltype(auto) raw_dispatch(F&& f) const {
+        return prelude::dispatch<k_size + 1>(this->storage_type::index, static_cast<F&&>(f));
     }
-};
 
+    // Construct alternative I in place. The variant must be empty.
+    template<size_type I, typename... Args>
+    void construct(Args&&... args) {
+        ::new(this->data()) alternative_type<I>(static_cast<Args&&>(args)...);
+        this->storage_type::index = static_cast<storage_type::index_type>(I + 1);
+    }
 
+    // Copy or move whatever other holds into this variant, which must be empty.
+    template<typename V>
+    void construct_from(V&& other) {
+        using source_type = std::remove_cvref_t<V>;
+        other.raw_dispatch([&]<size_type I>(constexpr_size<I>) {
+            if constexpr (I != 0) {
+                using T = source_type::template alternative_type<I - 1>;
+                this->template construct<k_index_of<T>>(static_cast<V&&>(other).template unchecked<I - 1>());
+            }
+        });
+    }
 
-} // namespace prelude
\ No newline at end of file
+    // Assign in place when both hold the same alternative, otherwise destroy and reconstruct.
+    template<typename V>
+    void assign_from(V&& other) {
+        if (this->storage_type::index != other.storage_type::index) {
+            this->destroy();
+            this->construct_from(static_cast<V&&>(other));
+            return;
+        }
+        this->raw_dispatch([&]<size_type I>(constexpr_size<I>) {
+            if constexpr (I != 0) {
+                this->template unchecked<I - 1>() = static_cast<V&&>(other).template unchecked<I - 1>();
+            }
+        });
+    }
+};
+
+/**
+ * @brief Call f with the current alternatives of all vars, which may be variants of different
+ * types. The combination is found with a single dispatch_flat() over every pair (or tuple) of
+ * alternatives. Throws bad_variant_access if any of the variants is empty.
+ *
+ * @example
+ * @code
+ *      auto area = visit([](auto const& a, auto const& b) { return overlap(a, b); }, lhs, rhs);
+ * @endcode
+ */
+template<typename F, typename... Vs>
+decltype(auto) visit(F&& f, Vs&&... vars) {
+    if ((vars.is_empty() || ...)) {
+        throw bad_variant_access();
+    }
+    return prelude::dispatch_flat<std::remove_cvref_t<Vs>::k_size...>(
+        [&]<prelude::size_t... I>(constexpr_size<I>...) -> decltype(auto) {
+            return static_cast<F&&>(f)(variant_access::get<I>(static_cast<Vs&&>(vars))...);
+        },
+        vars.index()...);
+}
+
+} // namespace prelude
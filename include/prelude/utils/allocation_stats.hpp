@@ -0,0 +1,364 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <typeinfo>
+
+#include "../defs.hpp"
+#include "sync.hpp"
+
+// Define to 1 to make instrumented_allocator record statistics. When 0, the wrapper forwards
+// straight to the underlying allocator and every snapshot is zero.
+#ifndef PRELUDE_ALLOCATION_STATS
+#define PRELUDE_ALLOCATION_STATS 0
+#endif
+
+namespace prelude {
+
+inline constexpr bool k_allocation_stats_enabled = PRELUDE_ALLOCATION_STATS != 0;
+
+/**
+ * @brief A point-in-time view of the statistics of one allocator type.
+ *
+ * Bucket i of the histogram counts requests of at most 2^i bytes (and more than 2^(i-1)); the last
+ * bucket also takes everything larger.
+ */
+struct allocation_snapshot {
+    static constexpr prelude::size_t k_histogram_size = 32;
+
+    char const* name = nullptr;
+    prelude::size_t allocations = 0;
+    prelude::size_t deallocations = 0;
+    prelude::ssize_t live_bytes = 0;
+    prelude::ssize_t peak_bytes = 0;
+    prelude::size_t histogram[k_histogram_size] = {};
+};
+
+class allocation_stats_base;
+
+// Registry of every allocator type that has recorded something, for exporting all of them.
+class allocation_stats_registry {
+public:
+    static void add(allocation_stats_base* stats) noexcept;
+
+    template<typename F>
+    static void for_each(F&& f);
+
+private:
+    static spin_lock& lock() noexcept {
+        static constinit spin_lock lock;
+        return lock;
+    }
+
+    static allocation_stats_base*& head() noexcept {
+        static constinit allocation_stats_base* head = nullptr;
+        return head;
+    }
+};
+
+/**
+ * @brief The statistics of one allocator type. Every thread records into its own counter block,
+ * which only that thread writes, so recording is a handful of uncontended relaxed stores. Blocks
+ * are merged when a snapshot is taken, and folded into a retired total when their thread exits.
+ *
+ * Live bytes are per thread as well and are published to a shared total every k_flush_bytes of
+ * drift; the high-water mark is taken over the published total, so it may be off by up to
+ * k_flush_bytes per thread.
+ */
+class allocation_stats_base {
+public:
+    using size_type = prelude::size_t;
+
+    static constexpr prelude::ssize_t k_flush_bytes = 64 * 1024;
+
+    explicit allocation_stats_base(char const* name) noexcept
+        : m_name(name) {}
+
+    allocation_stats_base(allocation_stats_base const&) = delete;
+
+    allocation_stats_base& operator =(allocation_stats_base const&) = delete;
+
+    struct counter_block {
+        std::atomic<size_type> allocations = 0;
+        std::atomic<size_type> deallocations = 0;
+        std::atomic<prelude::ssize_t> pending_bytes = 0;
+        std::atomic<size_type> histogram[allocation_snapshot::k_histogram_size] = {};
+        counter_block* next = nullptr;
+        counter_block* prev = nullptr;
+
+        // Only the owning thread writes, so a relaxed load and store is enough.
+        static void bump(std::atomic<size_type>& counter) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    };
+
+    // Registers a counter block on construction and folds it into the retired total on thread exit.
+    struct thread_counters : counter_block {
+        allocation_stats_base& owner;
+        counter_block*& slot;
+
+        thread_counters(allocation_stats_base& owner, counter_block*& slot)
+            : owner(owner), slot(slot) {
+
+            owner.attach(*this);
+            slot = this;
+        }
+
+        ~thread_counters() {
+            slot = nullptr;
+            owner.detach(*this);
+        }
+    };
+
+    // Records into the calling thread's block, or straight into the retired total if the thread's
+    // block has already been torn down.
+    void record_allocation(counter_block* counters, size_type bytes) {
+        if (counters == nullptr) {
+            auto guard = std::lock_guard(m_lock);
+            m_retired.bump(m_retired.allocations);
+            m_retired.bump(m_retired.histogram[allocation_stats_base::bucket(bytes)]);
+            this->publish(static_cast<prelude::ssize_t>(bytes));
+            return;
+        }
+        counters->bump(counters->allocations);
+        counters->bump(counters->histogram[allocation_stats_base::bucket(bytes)]);
+        this->drift(*counters, static_cast<prelude::ssize_t>(bytes));
+    }
+
+    void record_deallocation(counter_block* counters, size_type bytes) {
+        if (counters == nullptr) {
+            auto guard = std::lock_guard(m_lock);
+            m_retired.bump(m_retired.deallocations);
+            this->publish(-static_cast<prelude::ssize_t>(bytes));
+            return;
+        }
+        counters->bump(counters->deallocations);
+        this->drift(*counters, -static_cast<prelude::ssize_t>(bytes));
+    }
+
+    allocation_snapshot snapshot() const {
+        auto result = allocation_snapshot();
+        result.name = m_name;
+        auto guard = std::lock_guard(m_lock);
+        result.live_bytes = m_published.load(std::memory_order_relaxed);
+        this->accumulate(result, m_retired);
+        for (auto* it = m_threads; it != nullptr; it = it->next) {
+            this->accumulate(result, *it);
+        }
+        auto const peak = m_peak.load(std::memory_order_relaxed);
+        result.peak_bytes = peak > result.live_bytes ? peak : result.live_bytes;
+        return result;
+    }
+
+    allocation_stats_base* next_registered = nullptr;
+
+private:
+    static size_type bucket(size_type bytes) noexcept {
+        size_type i = 0;
+        while (i + 1 < allocation_snapshot::k_histogram_size && (size_type(1) << i) < bytes) {
+            ++i;
+        }
+        return i;
+    }
+
+    static void accumulate(allocation_snapshot& result, counter_block const& counters) noexcept {
+        result.allocations += counters.allocations.load(std::memory_order_relaxed);
+        result.deallocations += counters.deallocations.load(std::memory_order_relaxed);
+        result.live_bytes += counters.pending_bytes.load(std::memory_order_relaxed);
+        for (size_type i = 0; i < allocation_snapshot::k_histogram_size; ++i) {
+            result.histogram[i] += counters.histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void drift(counter_block& counters, prelude::ssize_t delta) noexcept {
+        auto const pending = counters.pending_bytes.load(std::memory_order_relaxed) + delta;
+        if (pending > -k_flush_bytes && pending < k_flush_bytes) {
+            counters.pending_bytes.store(pending, std::memory_order_relaxed);
+            return;
+        }
+        auto guard = std::lock_guard(m_lock);
+        counters.pending_bytes.store(0, std::memory_order_relaxed);
+        this->publish(pending);
+    }
+
+    // Must be called with m_lock held.
+    void publish(prelude::ssize_t delta) noexcept {
+        auto const live = m_published.load(std::memory_order_relaxed) + delta;
+        m_published.store(live, std::memory_order_relaxed);
+        if (live > m_peak.load(std::memory_order_relaxed)) {
+            m_peak.store(live, std::memory_order_relaxed);
+        }
+    }
+
+    void attach(counter_block& counters) {
+        {
+            auto guard = std::lock_guard(m_lock);
+            counters.next = m_threads;
+            if (m_threads != nullptr) {
+                m_threads->prev = &counters;
+            }
+            m_threads = &counters;
+        }
+        if (!m_registered.exchange(true, std::memory_order_relaxed)) {
+            allocation_stats_registry::add(this);
+        }
+    }
+
+    void detach(counter_block& counters) noexcept {
+        auto guard = std::lock_guard(m_lock);
+        if (counters.prev != nullptr) {
+            counters.prev->next = counters.next;
+        }
+        else {
+            m_threads = counters.next;
+        }
+        if (counters.next != nullptr) {
+            counters.next->prev = counters.prev;
+        }
+        auto fold = [](std::atomic<size_type>& into, std::atomic<size_type> const& from) {
+            into.store(into.load(std::memory_order_relaxed) + from.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        };
+        fold(m_retired.allocations, counters.allocations);
+        fold(m_retired.deallocations, counters.deallocations);
+        for (size_type i = 0; i < allocation_snapshot::k_histogram_size; ++i) {
+            fold(m_retired.histogram[i], counters.histogram[i]);
+        }
+        this->publish(counters.pending_bytes.load(std::memory_order_relaxed));
+    }
+
+    char const* m_name;
+    mutable spin_lock m_lock;
+    counter_block* m_threads = nullptr;
+    counter_block m_retired;
+    std::atomic<prelude::ssize_t> m_published = 0;
+    std::atomic<prelude::ssize_t> m_peak = 0;
+    std::atomic<bool> m_registered = false;
+};
+
+/**
+ * @brief The statistics of the allocator type Alloc.
+ *
+ * @example Exporting the numbers.
+ * @code
+ *      auto snap = allocation_stats<node_allocator<cons<int>>>::snapshot();
+ *      metrics.gauge("cons_live_bytes", snap.live_bytes);
+ *
+ *      allocation_stats_registry::for_each([](allocation_snapshot const& snap) {
+ *          metrics.counter(snap.name, snap.allocations);
+ *      });
+ * @endcode
+ */
+template<typename Alloc>
+class allocation_stats {
+public:
+    static allocation_stats_base& instance() noexcept {
+        // Intentionally leaked: allocators in static objects may still record during exit.
+        static auto* stats = new allocation_stats_base(typeid(Alloc).name());
+        return *stats;
+    }
+
+    static allocation_snapshot snapshot() {
+        return allocation_stats::instance().snapshot();
+    }
+
+    static void record_allocation(prelude::size_t bytes) {
+        allocation_stats::instance().record_allocation(allocation_stats::local(), bytes);
+    }
+
+    static void record_deallocation(prelude::size_t bytes) {
+        allocation_stats::instance().record_deallocation(allocation_stats::local(), bytes);
+    }
+
+private:
+    // The calling thread's counter block, or nullptr once it has been torn down at thread exit.
+    static allocation_stats_base::counter_block* local() {
+        thread_local constinit allocation_stats_base::counter_block* slot = nullptr;
+        thread_local constinit bool created = false;
+        if (!created) {
+            created = true;
+            thread_local allocation_stats_base::thread_counters counters(allocation_stats::instance(), slot);
+        }
+        return slot;
+    }
+};
+
+inline void allocation_stats_registry::add(allocation_stats_base* stats) noexcept {
+    auto guard = std::lock_guard(allocation_stats_registry::lock());
+    stats->next_registered = allocation_stats_registry::head();
+    allocation_stats_registry::head() = stats;
+}
+
+template<typename F>
+void allocation_stats_registry::for_each(F&& f) {
+    allocation_stats_base* head = nullptr;
+    {
+        auto guard = std::lock_guard(allocation_stats_registry::lock());
+        head = allocation_stats_registry::head();
+    }
+    // Entries are only ever prepended, so the list behind the head we read is stable.
+    for (auto* it = head; it != nullptr; it = it->next_registered) {
+        f(it->snapshot());
+    }
+}
+
+/**
+ * @brief Wraps an allocator with the basic_allocator/node_allocator interface and records every
+ * allocation and deallocation into allocation_stats<Alloc>. With PRELUDE_ALLOCATION_STATS set to
+ * 0 the recording compiles away and the wrapper is as cheap as Alloc itself.
+ *
+ * @tparam Alloc The underlying allocator.
+ */
+template<typename Alloc>
+class instrumented_allocator : private Alloc {
+public:
+    using allocator_type = Alloc;
+    using value_type = Alloc::value_type;
+    using pointer_type = Alloc::pointer_type;
+    using size_type = Alloc::size_type;
+
+    instrumented_allocator() = default;
+
+    instrumented_allocator(Alloc const& alloc)
+        : Alloc(alloc) {}
+
+    [[nodiscard]]
+    pointer_type allocate(size_type n) {
+        auto* p = Alloc::allocate(n);
+        if constexpr (k_allocation_stats_enabled) {
+            allocation_stats<Alloc>::record_allocation(n * sizeof(value_type));
+        }
+        return p;
+    }
+
+    [[nodiscard]]
+    auto allocate_at_least(size_type n) requires requires (Alloc& alloc, size_type k) { alloc.allocate_at_least(k); } {
+        auto result = Alloc::allocate_at_least(n);
+        if constexpr (k_allocation_stats_enabled) {
+            allocation_stats<Alloc>::record_allocation(result.count * sizeof(value_type));
+        }
+        return result;
+    }
+
+    template<typename... Args>
+    pointer_type construct(pointer_type ptr, Args&&... args) {
+        return Alloc::construct(ptr, static_cast<Args&&>(args)...);
+    }
+
+    void deallocate(pointer_type p, size_type n) {
+        if constexpr (k_allocation_stats_enabled) {
+            allocation_stats<Alloc>::record_deallocation(n * sizeof(value_type));
+        }
+        Alloc::deallocate(p, n);
+    }
+
+    template<typename... Args>
+    pointer_type new_object(Args&&... args) {
+        return construct(allocate(1), static_cast<Args&&>(args)...);
+    }
+
+    static allocation_snapshot snapshot() {
+        return allocation_stats<Alloc>::snapshot();
+    }
+};
+
+} // namespace prelude
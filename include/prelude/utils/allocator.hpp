@@ -1,21 +1,111 @@
 #pragma once
 
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
 #include "../defs.hpp"
+#include "sync.hpp"
 
 namespace prelude {
 
+/**
+ * @brief The result of allocate_at_least: the storage and the number of objects it can really hold,
+ * which may be more than requested. The count must be passed back to deallocate.
+ */
+template<typename Ptr>
+struct allocation_result {
+    Ptr ptr;
+    prelude::size_t count;
+};
+
+/**
+ * @brief The number of bytes the global heap really hands out for a request of the given size.
+ * glibc's malloc rounds a request up to 16-byte chunks that carry an 8-byte header, with a 32-byte
+ * minimum chunk; elsewhere we assume requests come in multiples of the default new alignment.
+ */
+constexpr prelude::size_t heap_usable_size(prelude::size_t bytes) noexcept {
+    constexpr prelude::size_t granularity = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+#if defined(__GLIBC__)
+    constexpr prelude::size_t header = sizeof(void*);
+    constexpr prelude::size_t min_usable = 2 * granularity - header;
+    auto const usable = (bytes + header + granularity - 1) / granularity * granularity - header;
+    return usable < min_usable ? min_usable : usable;
+#else
+    return (bytes + granularity - 1) / granularity * granularity;
+#endif
+}
+
+// Move n objects from first into uninitialized storage at out, ending the lifetime of the originals.
+// Trivially copyable objects are moved with a single memmove, so the ranges may overlap.
+template<typename T>
+inline void relocate(T* first, prelude::size_t n, T* out) {
+    if (out == first) {
+        // Already in place; moving each object onto itself would destroy it.
+        return;
+    }
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        if (n != 0) {
+            std::memmove(static_cast<void*>(out), static_cast<void const*>(first), n * sizeof(T));
+        }
+    }
+    else if (out < first) {
+        for (prelude::size_t i = 0; i < n; ++i) {
+            ::new(out + i) T(static_cast<T&&>(first[i]));
+            first[i].~T();
+        }
+    }
+    else {
+        for (prelude::size_t i = n; i-- > 0; ) {
+            ::new(out + i) T(static_cast<T&&>(first[i]));
+            first[i].~T();
+        }
+    }
+}
+
+template<typename T>
+inline void destroy(T* first, T* last) noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        while (first != last) {
+            (first++)->~T();
+        }
+    }
+}
+
 template<typename T>
 class basic_allocator {
 public:
     using value_type = T;
-    using pointer_type = Ptr;
+    using pointer_type = T*;
     using size_type = prelude::size_t;
 
+    // Types aligned more strictly than plain operator new guarantees take the std::align_val_t path.
+    static constexpr bool k_over_aligned = alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
     basic_allocator() noexcept = default;
 
     [[nodiscard]]
     T* allocate(size_type n) {
-        return static_cast<T*>(::operator new(n * sizeof(T)));
+        if constexpr (k_over_aligned) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        }
+        else {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+    }
+
+    /**
+     * @brief Allocate room for at least n objects and report how many really fit, so that growable
+     * containers can use the slack the heap hands out anyway instead of reallocating early.
+     */
+    [[nodiscard]]
+    allocation_result<T*> allocate_at_least(size_type n) {
+        auto count = n;
+        if constexpr (!k_over_aligned) {
+            count = heap_usable_size(n * sizeof(T)) / sizeof(T);
+        }
+        return { this->allocate(count), count };
     }
 
     template<typename... Args>
@@ -24,7 +114,12 @@ public:
     }
 
     void deallocate(T* p, size_type n) {
-        ::operator delete(p);
+        if constexpr (k_over_aligned) {
+            ::operator delete(p, n * sizeof(T), std::align_val_t(alignof(T)));
+        }
+        else {
+            ::operator delete(p, n * sizeof(T));
+        }
     }
 
     template<typename... Args>
@@ -33,18 +128,350 @@ public:
     }
 };
 
+/**
+ * @brief A pool of fixed-size blocks. Blocks are carved out of large slabs with a bump pointer,
+ * and freed blocks are kept on an intrusive free list threaded through the blocks themselves, so
+ * an allocation is a pointer pop in the common case and no bookkeeping is stored per block.
+ * Slabs are only returned to the system when the pool is released or destroyed.
+ *
+ * The pool is not thread-safe; see shared_slab_pool for the process-wide variant.
+ *
+ * @tparam BlockSize The size of a block in bytes.
+ * @tparam BlockAlign The alignment of a block.
+ */
+template<prelude::size_t BlockSize, prelude::size_t BlockAlign>
+class slab_pool {
+    struct free_block {
+        free_block* next;
+    };
+
+    struct slab_header {
+        slab_header* next;
+    };
+
+    static constexpr prelude::size_t round_up(prelude::size_t n, prelude::size_t align) noexcept {
+        return (n + align - 1) / align * align;
+    }
+
+public:
+    using size_type = prelude::size_t;
+
+    static constexpr size_type k_block_align = BlockAlign > alignof(free_block) ? BlockAlign : alignof(free_block);
+    static constexpr size_type k_block_size = round_up(BlockSize > sizeof(free_block) ? BlockSize : sizeof(free_block), k_block_align);
+    static constexpr size_type k_header_size = round_up(sizeof(slab_header), k_block_align);
+    static constexpr size_type k_min_blocks_per_slab = 16;
+    static constexpr size_type k_slab_size = k_header_size + k_min_blocks_per_slab * k_block_size > 64 * 1024
+        ? k_header_size + k_min_blocks_per_slab * k_block_size
+        : 64 * 1024;
+    static constexpr size_type k_blocks_per_slab = (k_slab_size - k_header_size) / k_block_size;
+
+    constexpr slab_pool() noexcept = default;
+
+    slab_pool(slab_pool const&) = delete;
+
+    slab_pool& operator =(slab_pool const&) = delete;
+
+    ~slab_pool() {
+        this->release();
+    }
+
+    [[nodiscard]]
+    void* allocate() {
+        if (m_free != nullptr) {
+            auto* block = m_free;
+            m_free = block->next;
+            return block;
+        }
+        if (m_cursor == m_limit) {
+            this->grow();
+        }
+        auto* block = m_cursor;
+        m_cursor += k_block_size;
+        return block;
+    }
+
+    void deallocate(void* p) noexcept {
+        auto* block = static_cast<free_block*>(p);
+        block->next = m_free;
+        m_free = block;
+    }
+
+    /**
+     * @brief Return every slab to the system at once. All blocks handed out by this pool become
+     * invalid, whether they have been deallocated or not.
+     */
+    void release() noexcept {
+        while (m_slabs != nullptr) {
+            auto* next = m_slabs->next;
+            ::operator delete(static_cast<void*>(m_slabs), k_slab_size, std::align_val_t(k_block_align));
+            m_slabs = next;
+        }
+        m_free = nullptr;
+        m_cursor = nullptr;
+        m_limit = nullptr;
+    }
+
+private:
+    void grow() {
+        auto* slab = static_cast<unsigned char*>(::operator new(k_slab_size, std::align_val_t(k_block_align)));
+        auto* header = ::new(slab) slab_header { m_slabs };
+        m_slabs = header;
+        m_cursor = slab + k_header_size;
+        m_limit = m_cursor + k_blocks_per_slab * k_block_size;
+    }
+
+    free_block* m_free = nullptr;
+    unsigned char* m_cursor = nullptr;
+    unsigned char* m_limit = nullptr;
+    slab_header* m_slabs = nullptr;
+};
+
+/**
+ * @brief The process-wide slab_pool for one block size and alignment, guarded by a spin lock.
+ * Every node type of the same size and alignment shares the same pool.
+ *
+ * The pool also acts as the depot for thread_slab_cache: it keeps lists of full and empty
+ * magazines, and threads trade whole magazines with it, so the lock is taken once per
+ * k_magazine_size allocations or frees rather than once per block.
+ */
+template<prelude::size_t BlockSize, prelude::size_t BlockAlign>
+class shared_slab_pool {
+public:
+    using pool_type = slab_pool<BlockSize, BlockAlign>;
+    using size_type = prelude::size_t;
+
+    static constexpr size_type k_magazine_size = 64;
+
+    struct magazine {
+        magazine* next = nullptr;
+        size_type count = 0;
+        void* blocks[k_magazine_size];
+    };
+
+    [[nodiscard]]
+    static void* allocate() {
+        auto& state = shared_slab_pool::instance();
+        auto guard = std::lock_guard(state.lock);
+        return state.pool.allocate();
+    }
+
+    static void deallocate(void* p) noexcept {
+        auto& state = shared_slab_pool::instance();
+        auto guard = std::lock_guard(state.lock);
+        state.pool.deallocate(p);
+    }
+
+    /**
+     * @brief Trade an empty magazine for a loaded one. If the depot holds no loaded magazine, the
+     * given one is filled straight from the pool under the same lock.
+     */
+    [[nodiscard]]
+    static magazine* exchange_empty(magazine* empty) {
+        auto& state = shared_slab_pool::instance();
+        auto guard = std::lock_guard(state.lock);
+        if (state.full != nullptr) {
+            auto* full = state.full;
+            state.full = full->next;
+            empty->next = state.empty;
+            state.empty = empty;
+            return full;
+        }
+        while (empty->count < k_magazine_size) {
+            empty->blocks[empty->count++] = state.pool.allocate();
+        }
+        return empty;
+    }
+
+    /**
+     * @brief Trade a full magazine for an empty one. If the depot holds no empty magazine, the
+     * blocks go straight back to the pool under the same lock and the given magazine is returned
+     * empty, so freeing never allocates.
+     */
+    [[nodiscard]]
+    static magazine* exchange_full(magazine* full) noexcept {
+        auto& state = shared_slab_pool::instance();
+        auto guard = std::lock_guard(state.lock);
+        if (state.empty != nullptr) {
+            auto* empty = state.empty;
+            state.empty = empty->next;
+            full->next = state.full;
+            state.full = full;
+            return empty;
+        }
+        while (full->count > 0) {
+            state.pool.deallocate(full->blocks[--full->count]);
+        }
+        return full;
+    }
+
+    [[nodiscard]]
+    static magazine* take_empty() {
+        auto& state = shared_slab_pool::instance();
+        {
+            auto guard = std::lock_guard(state.lock);
+            if (state.empty != nullptr) {
+                auto* empty = state.empty;
+                state.empty = empty->next;
+                return empty;
+            }
+        }
+        return new magazine();
+    }
+
+    // Hand a magazine back to the depot, loaded or not. Used when a thread exits.
+    static void give_back(magazine* mag) noexcept {
+        auto& state = shared_slab_pool::instance();
+        auto guard = std::lock_guard(state.lock);
+        auto& list = mag->count > 0 ? state.full : state.empty;
+        mag->next = list;
+        list = mag;
+    }
+
+private:
+    struct state_type {
+        spin_lock lock;
+        pool_type pool;
+        magazine* full = nullptr;
+        magazine* empty = nullptr;
+    };
+
+    static state_type& instance() noexcept {
+        // Intentionally leaked: nodes owned by static objects may still be freed during exit.
+        static auto* state = new state_type();
+        return *state;
+    }
+};
+
+/**
+ * @brief A per-thread cache in front of shared_slab_pool, in the style of Bonwick's magazines.
+ * Each thread holds a loaded and a previous magazine of free blocks; allocation and deallocation
+ * only touch these until both are empty (or both full), at which point a whole magazine is traded
+ * with the depot. Threads therefore neither contend on the pool lock nor share cache lines in the
+ * common case.
+ *
+ * A block freed on another thread goes into that thread's magazines, and full magazines flow back
+ * to the depot, which owns every slab; a thread never keeps more than two magazines of blocks, and
+ * hands them back when it exits. After that point the thread falls through to the locked pool, as
+ * does a thread that frees before it has ever allocated, so deallocation never throws.
+ */
+template<prelude::size_t BlockSize, prelude::size_t BlockAlign>
+class thread_slab_cache {
+public:
+    using depot_type = shared_slab_pool<BlockSize, BlockAlign>;
+    using magazine = depot_type::magazine;
+
+    [[nodiscard]]
+    static void* allocate() {
+        auto* cache = thread_slab_cache::local();
+        if (cache == nullptr) {
+            return depot_type::allocate();
+        }
+        return cache->pop();
+    }
+
+    static void deallocate(void* p) noexcept {
+        // Freeing never sets up a cache, since that would allocate its magazines.
+        auto* cache = thread_slab_cache::state().cache;
+        if (cache == nullptr) {
+            depot_type::deallocate(p);
+            return;
+        }
+        cache->push(p);
+    }
+
+private:
+    struct thread_state {
+        thread_slab_cache* cache = nullptr;
+        bool retired = false;
+    };
+
+    explicit thread_slab_cache(thread_state& state)
+        : m_state(state),
+          m_loaded(depot_type::take_empty()),
+          m_previous(depot_type::take_empty()) {}
+
+    thread_slab_cache(thread_slab_cache const&) = delete;
+
+    ~thread_slab_cache() {
+        depot_type::give_back(m_loaded);
+        depot_type::give_back(m_previous);
+        m_state.cache = nullptr;
+        m_state.retired = true;
+    }
+
+    static thread_state& state() noexcept {
+        // The state is trivially destructible, so it stays usable after the cache itself has been
+        // destroyed during thread exit.
+        thread_local constinit thread_state state;
+        return state;
+    }
+
+    static thread_slab_cache* local() {
+        auto& state = thread_slab_cache::state();
+        if (state.cache == nullptr && !state.retired) {
+            thread_local thread_slab_cache cache(state);
+            state.cache = &cache;
+        }
+        return state.cache;
+    }
+
+    void* pop() {
+        if (m_loaded->count == 0) {
+            if (m_previous->count > 0) {
+                auto* tmp = m_loaded;
+                m_loaded = m_previous;
+                m_previous = tmp;
+            }
+            else {
+                m_loaded = depot_type::exchange_empty(m_loaded);
+            }
+        }
+        return m_loaded->blocks[--m_loaded->count];
+    }
+
+    void push(void* p) noexcept {
+        if (m_loaded->count == depot_type::k_magazine_size) {
+            if (m_previous->count < depot_type::k_magazine_size) {
+                auto* tmp = m_loaded;
+                m_loaded = m_previous;
+                m_previous = tmp;
+            }
+            else {
+                m_loaded = depot_type::exchange_full(m_loaded);
+            }
+        }
+        m_loaded->blocks[m_loaded->count++] = p;
+    }
+
+    thread_state& m_state;
+    magazine* m_loaded;
+    magazine* m_previous;
+};
+
+/**
+ * @brief The allocator for linked nodes. Single nodes come from the calling thread's
+ * thread_slab_cache for the node's size and alignment, backed by the shared_slab_pool, so building a
+ * list costs a magazine pop per node instead of a call into the global heap, and consecutive nodes
+ * tend to be adjacent in memory. Requests for several nodes at once still go to the global heap.
+ *
+ * @tparam Node The node type.
+ */
 template<typename Node>
 class node_allocator {
 public:
-    using value_type = Node::value_type;
+    using value_type = Node;
     using pointer_type = Node*;
     using size_type = prelude::size_t;
+    using pool_type = thread_slab_cache<sizeof(Node), alignof(Node)>;
 
     node_allocator() noexcept = default;
 
     [[nodiscard]]
     Node* allocate(size_type n) {
-        return static_cast<Node*>(::operator new(n * sizeof(Node)));
+        if (n == 1) {
+            return static_cast<Node*>(pool_type::allocate());
+        }
+        return basic_allocator<Node>().allocate(n);
     }
 
     template<typename... Args>
@@ -52,8 +479,12 @@ public:
         return ::new(ptr) Node(static_cast<Args&&>(args)...);
     }
 
-    void deallocate(Node* p, size_type n) {
-        ::operator delete(p);
+    void deallocate(Node* p, size_type n) noexcept {
+        if (n == 1) {
+            pool_type::deallocate(p);
+            return;
+        }
+        basic_allocator<Node>().deallocate(p, n);
     }
 
     template<typename... Args>
@@ -62,5 +493,203 @@ public:
     }
 };
 
+/**
+ * @brief A monotonic (bump) arena. Allocation advances a cursor through the current buffer, and
+ * individual deallocation does nothing; everything is released at once by reset() or when the
+ * arena is destroyed. The arena starts from an optional caller-provided buffer and spills into
+ * heap chunks of geometrically growing size.
+ *
+ * @example Scratch structures on the stack.
+ * @code
+ *      alignas(k_cache_line_size) unsigned char buffer[4096];
+ *      auto arena = monotonic_arena(buffer, sizeof(buffer));
+ *      auto alloc = arena_allocator<binary_tree_node<int>>(arena);
+ *      auto* root = alloc.new_object(1, nullptr, nullptr);
+ *      // ... build and query the tree; no node is ever freed individually.
+ * @endcode
+ */
+class monotonic_arena {
+    struct chunk_header {
+        chunk_header* next;
+        prelude::size_t size;
+    };
+
+public:
+    using size_type = prelude::size_t;
+
+    static constexpr size_type k_initial_chunk_size = 4096;
+
+    constexpr monotonic_arena() noexcept = default;
+
+    monotonic_arena(void* buffer, size_type size) noexcept
+        : m_buffer(static_cast<unsigned char*>(buffer)),
+          m_buffer_size(size),
+          m_cursor(m_buffer),
+          m_limit(m_buffer + size),
+          m_next_chunk_size(size * 2 > k_initial_chunk_size ? size * 2 : k_initial_chunk_size) {}
+
+    monotonic_arena(monotonic_arena const&) = delete;
+
+    monotonic_arena& operator =(monotonic_arena const&) = delete;
+
+    ~monotonic_arena() {
+        this->release_chunks(m_chunks);
+        this->release_chunks(m_spare);
+    }
+
+    [[nodiscard]]
+    void* allocate(size_type size, size_type align) {
+        auto* ptr = monotonic_arena::align_up(m_cursor, align);
+        if (ptr == nullptr || ptr + size > m_limit) {
+            this->grow(size, align);
+            ptr = monotonic_arena::align_up(m_cursor, align);
+        }
+        m_cursor = ptr + size;
+        return ptr;
+    }
+
+    /**
+     * @brief Release every allocation at once and rewind to the initial buffer. The most recent
+     * heap chunk is kept for the next spill, so an arena reused across requests of similar size
+     * stops touching the heap after the first one.
+     */
+    void reset() noexcept {
+        if (m_chunks != nullptr) {
+            this->release_chunks(m_spare);
+            m_spare = m_chunks;
+            this->release_chunks(m_spare->next);
+            m_spare->next = nullptr;
+            m_chunks = nullptr;
+        }
+        m_cursor = m_buffer;
+        m_limit = m_buffer + m_buffer_size;
+    }
+
+    // The arena installed by the innermost arena_scope on the calling thread.
+    static monotonic_arena*& current() noexcept {
+        thread_local monotonic_arena* arena = nullptr;
+        return arena;
+    }
+
+private:
+    static unsigned char* align_up(unsigned char* ptr, size_type align) noexcept {
+        if (ptr == nullptr) {
+            return nullptr;
+        }
+        auto const addr = reinterpret_cast<prelude::size_t>(ptr);
+        return ptr + ((align - addr % align) % align);
+    }
+
+    void grow(size_type size, size_type align) {
+        auto const needed = sizeof(chunk_header) + size + align;
+        chunk_header* chunk = nullptr;
+        if (m_spare != nullptr && m_spare->size >= needed) {
+            chunk = m_spare;
+            m_spare = nullptr;
+        }
+        else {
+            auto chunk_size = m_next_chunk_size;
+            while (chunk_size < needed) {
+                chunk_size *= 2;
+            }
+            m_next_chunk_size = chunk_size * 2;
+            chunk = ::new(::operator new(chunk_size)) chunk_header { nullptr, chunk_size };
+        }
+        chunk->next = m_chunks;
+        m_chunks = chunk;
+        m_cursor = reinterpret_cast<unsigned char*>(chunk + 1);
+        m_limit = reinterpret_cast<unsigned char*>(chunk) + chunk->size;
+    }
+
+    static void release_chunks(chunk_header* chunk) noexcept {
+        while (chunk != nullptr) {
+            auto* next = chunk->next;
+            ::operator delete(static_cast<void*>(chunk));
+            chunk = next;
+        }
+    }
+
+    unsigned char* m_buffer = nullptr;
+    size_type m_buffer_size = 0;
+    unsigned char* m_cursor = nullptr;
+    unsigned char* m_limit = nullptr;
+    size_type m_next_chunk_size = k_initial_chunk_size;
+    chunk_header* m_chunks = nullptr;
+    chunk_header* m_spare = nullptr;
+};
+
+/**
+ * @brief An allocator drawing from a monotonic_arena, with the same interface as basic_allocator
+ * and node_allocator. deallocate() is a no-op; memory comes back when the arena is reset.
+ *
+ * A default-constructed arena_allocator binds to the arena installed by the innermost arena_scope
+ * on the calling thread, so containers that default-construct their allocator can use it too.
+ */
+template<typename T>
+class arena_allocator {
+public:
+    using value_type = T;
+    using pointer_type = T*;
+    using size_type = prelude::size_t;
+
+    arena_allocator() noexcept
+        : m_arena(monotonic_arena::current()) {}
+
+    arena_allocator(monotonic_arena& arena) noexcept
+        : m_arena(&arena) {}
+
+    template<typename U>
+    arena_allocator(arena_allocator<U> const& other) noexcept
+        : m_arena(other.arena()) {}
+
+    monotonic_arena* arena() const noexcept {
+        return m_arena;
+    }
+
+    [[nodiscard]]
+    T* allocate(size_type n) {
+        return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    template<typename... Args>
+    T* construct(T* ptr, Args&&... args) {
+        return ::new(ptr) T(static_cast<Args&&>(args)...);
+    }
+
+    void deallocate(T*, size_type) noexcept {}
+
+    template<typename... Args>
+    T* new_object(Args&&... args) {
+        return construct(allocate(1), static_cast<Args&&>(args)...);
+    }
+
+private:
+    monotonic_arena* m_arena;
+};
+
+/**
+ * @brief Installs an arena for default-constructed arena_allocators on this thread until the
+ * scope ends. Scopes nest.
+ */
+class arena_scope {
+public:
+    explicit arena_scope(monotonic_arena& arena) noexcept
+        : m_previous(monotonic_arena::current()) {
+
+        monotonic_arena::current() = &arena;
+    }
+
+    arena_scope(arena_scope const&) = delete;
+
+    arena_scope& operator =(arena_scope const&) = delete;
+
+    ~arena_scope() {
+        monotonic_arena::current() = m_previous;
+    }
+
+private:
+    monotonic_arena* m_previous;
+};
+
 
-} // namespace prelude
\ No newline at end of file
+} // namespace prelude
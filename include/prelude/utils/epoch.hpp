@@ -0,0 +1,271 @@
+#pragma once
+
+#include <atomic>
+#include <type_traits>
+
+#include "../defs.hpp"
+#include "allocator.hpp"
+
+namespace prelude {
+
+/**
+ * @brief Process-wide epoch-based memory reclamation (EBR) for lock-free node structures.
+ *
+ * Readers pin the current epoch with an epoch_guard for as long as they hold pointers into a shared
+ * structure. A thread that unlinks a node retires it instead of freeing it; the node is stamped
+ * with the global epoch at that moment and kept on the thread's own retire list. The global epoch
+ * only advances once every pinned thread has caught up with it, so once it has moved two steps past
+ * a node's stamp, every reader that could have seen the node has unpinned, and the node is freed.
+ *
+ * Pinning is a store and a fence on a cache line owned by the thread; retiring appends to a
+ * thread-local batch, and every k_collect_interval retirements the thread tries to advance the
+ * epoch and frees whatever has become safe, in bulk.
+ *
+ * @example Popping from a lock-free list.
+ * @code
+ *      auto guard = epoch_guard();
+ *      auto* node = pop_somehow(head);
+ *      epoch_domain::retire_node(node);    // goes back to node_allocator two epochs later
+ * @endcode
+ */
+class epoch_domain {
+public:
+    using size_type = prelude::size_t;
+    using reclaim_type = void (*)(void*);
+
+    static constexpr size_type k_batch_size = 64;
+    static constexpr size_type k_collect_interval = 64;
+
+    // Pin the calling thread. Pins nest; only the outermost one publishes the epoch.
+    static void enter() {
+        auto* self = epoch_domain::local();
+        if (self->depth++ == 0) {
+            auto const epoch = s_epoch.load(std::memory_order_relaxed);
+            self->state.store((epoch << 1) | 1, std::memory_order_relaxed);
+            // Our pin must be visible before we read any shared pointer.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    static void leave() noexcept {
+        auto* self = epoch_domain::local();
+        if (--self->depth == 0) {
+            self->state.store(0, std::memory_order_release);
+            epoch_domain::unbind(self);
+        }
+    }
+
+    /**
+     * @brief Defer reclaim(ptr) until no pinned thread can still be reading ptr. The object must
+     * already be unreachable from the shared structure.
+     */
+    static void retire(void* ptr, reclaim_type reclaim) {
+        auto* self = epoch_domain::local();
+        ++self->depth;
+        // Stamp with the global epoch as seen after the unlink, not with our pinned epoch: readers
+        // that found the node pinned no later than this.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto const epoch = s_epoch.load(std::memory_order_acquire);
+        auto& bag = self->bags[epoch % 3];
+        if (bag.epoch != epoch) {
+            // Whatever is left in this bag is from three epochs ago and is safe by now.
+            epoch_domain::reclaim_bag(bag);
+            bag.epoch = epoch;
+        }
+        epoch_domain::push(bag, ptr, reclaim);
+        if (++self->retirements % k_collect_interval == 0) {
+            epoch_domain::collect(self);
+        }
+        if (--self->depth == 0) {
+            epoch_domain::unbind(self);
+        }
+    }
+
+    // Retire a node that came from Alloc; it is destroyed and handed back to Alloc once safe. The
+    // reclaimer only has the node pointer, so it frees through a default-constructed Alloc.
+    template<typename Node, typename Alloc = prelude::node_allocator<Node>>
+    static void retire_node(Node* node) {
+        static_assert(std::is_empty_v<Alloc>, "retire_node needs a stateless allocator");
+        epoch_domain::retire(node, [](void* p) {
+            auto* node = static_cast<Node*>(p);
+            node->~Node();
+            Alloc().deallocate(node, 1);
+        });
+    }
+
+    // Try to advance the epoch and free everything the calling thread retired that is now safe.
+    static void collect() {
+        auto* self = epoch_domain::local();
+        ++self->depth;
+        epoch_domain::collect(self);
+        if (--self->depth == 0) {
+            epoch_domain::unbind(self);
+        }
+    }
+
+private:
+    struct retired_item {
+        void* ptr;
+        reclaim_type reclaim;
+    };
+
+    struct batch {
+        batch* next = nullptr;
+        size_type count = 0;
+        retired_item items[k_batch_size];
+    };
+
+    struct bag_type {
+        batch* batches = nullptr;
+        size_type epoch = 0;
+    };
+
+    // One per thread, recycled across threads and never freed.
+    struct alignas(k_cache_line_size) participant {
+        // The pinned epoch shifted left by one, with the low bit set while pinned.
+        std::atomic<size_type> state = 0;
+        std::atomic<bool> owned = true;
+        participant* next = nullptr;
+        size_type depth = 0;
+        size_type retirements = 0;
+        bag_type bags[3];
+    };
+
+    struct thread_state {
+        participant* self = nullptr;
+        bool retired = false;
+    };
+
+    // Gives the participant back when the thread exits.
+    struct thread_binding {
+        thread_state& state;
+
+        ~thread_binding() {
+            auto* self = state.self;
+            state.self = nullptr;
+            state.retired = true;
+            epoch_domain::collect(self);
+            epoch_domain::release(self);
+        }
+    };
+
+    static thread_state& state() noexcept {
+        thread_local constinit thread_state state;
+        return state;
+    }
+
+    static participant* local() {
+        auto& state = epoch_domain::state();
+        if (state.self == nullptr) {
+            state.self = epoch_domain::acquire();
+            if (!state.retired) {
+                thread_local thread_binding binding { state };
+            }
+        }
+        return state.self;
+    }
+
+    // Past its thread-local teardown a thread only borrows a participant, until it is unpinned.
+    static void unbind(participant* self) noexcept {
+        auto& state = epoch_domain::state();
+        if (state.retired) {
+            state.self = nullptr;
+            epoch_domain::release(self);
+        }
+    }
+
+    static participant* acquire() {
+        for (auto* it = s_participants.load(std::memory_order_acquire); it != nullptr; it = it->next) {
+            if (!it->owned.load(std::memory_order_relaxed) && !it->owned.exchange(true, std::memory_order_acquire)) {
+                return it;
+            }
+        }
+        auto* self = new participant();
+        auto* head = s_participants.load(std::memory_order_relaxed);
+        do {
+            self->next = head;
+        } while (!s_participants.compare_exchange_weak(head, self, std::memory_order_release, std::memory_order_relaxed));
+        return self;
+    }
+
+    // Whatever the participant still holds is freed by whichever thread adopts it next.
+    static void release(participant* self) noexcept {
+        self->owned.store(false, std::memory_order_release);
+    }
+
+    static bool try_advance() noexcept {
+        auto epoch = s_epoch.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (auto* it = s_participants.load(std::memory_order_acquire); it != nullptr; it = it->next) {
+            // Acquire pairs with leave()'s release, so the reads done under that pin happen before
+            // anything freed on the strength of this advance.
+            auto const state = it->state.load(std::memory_order_acquire);
+            if ((state & 1) != 0 && (state >> 1) != epoch) {
+                return false;
+            }
+        }
+        return s_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel, std::memory_order_relaxed);
+    }
+
+    static void collect(participant* self) {
+        epoch_domain::try_advance();
+        auto const epoch = s_epoch.load(std::memory_order_acquire);
+        for (auto& bag : self->bags) {
+            if (bag.batches != nullptr && bag.epoch + 2 <= epoch) {
+                epoch_domain::reclaim_bag(bag);
+            }
+        }
+    }
+
+    static void push(bag_type& bag, void* ptr, reclaim_type reclaim) {
+        if (bag.batches == nullptr || bag.batches->count == k_batch_size) {
+            auto* fresh = new batch();
+            fresh->next = bag.batches;
+            bag.batches = fresh;
+        }
+        bag.batches->items[bag.batches->count++] = { ptr, reclaim };
+    }
+
+    // Free everything in the bag, keeping one batch around for reuse.
+    static void reclaim_bag(bag_type& bag) {
+        auto* it = bag.batches;
+        while (it != nullptr) {
+            for (size_type i = 0; i < it->count; ++i) {
+                it->items[i].reclaim(it->items[i].ptr);
+            }
+            it->count = 0;
+            auto* next = it->next;
+            if (it != bag.batches) {
+                delete it;
+            }
+            it = next;
+        }
+        if (bag.batches != nullptr) {
+            bag.batches->next = nullptr;
+        }
+    }
+
+    static inline constinit std::atomic<size_type> s_epoch = 0;
+    static inline constinit std::atomic<participant*> s_participants = nullptr;
+};
+
+/**
+ * @brief Pins the calling thread to the current epoch for the lifetime of the guard, so that no
+ * node retired from now on is freed while the guard is alive.
+ */
+class epoch_guard {
+public:
+    epoch_guard() {
+        epoch_domain::enter();
+    }
+
+    epoch_guard(epoch_guard const&) = delete;
+
+    epoch_guard& operator =(epoch_guard const&) = delete;
+
+    ~epoch_guard() {
+        epoch_domain::leave();
+    }
+};
+
+} // namespace prelude
@@ -12,13 +12,13 @@ template<prelude::size_t I, typename FSig>
 struct nth_argument;
 
 template<prelude::size_t I, typename R, typename List>
-struct nth_argument<I, function_signature<R, List>> : nth<I, List> {};
+struct nth_argument<I, function_signature<R, List>> : type_nth<I, List> {};
 
 template<typename FSig>
 struct return_value;
 
 template<typename R, typename List>
-struct return_value<function_signature<R, List>> : type<R> {};
+struct return_value<function_signature<R, List>> : type_wrapper<R> {};
 
 
 
@@ -53,22 +53,22 @@ constexpr auto valueof = Expr::value;
 // Type wrapper
 
 template<typename... Ts>
-struct void_t {};
+using void_t = void;
 
 template<typename T, typename Test = void>
-struct type {
+struct type_wrapper {
     using type = T;
 };
 
 template<typename T>
-struct type<T, prelude::void_t<typename T::type>> {
+struct type_wrapper<T, prelude::void_t<typename T::type>> {
     using type = T::type;
 };
 
 template<typename T>
-using typeof = type<T>::type;
+using typeof = type_wrapper<T>::type;
 
-using null = type<std::nullptr_t>;
+using null = type_wrapper<std::nullptr_t>;
 
 // Type operations
 
@@ -76,10 +76,10 @@ template<typename Cond, typename Then, typename Else>
 struct branch;
 
 template<typename Then, typename Else>
-struct branch<constexpr_bool<true>, Then, Else> : type<Then> {};
+struct branch<constexpr_bool<true>, Then, Else> : type_wrapper<Then> {};
 
 template<typename Then, typename Else>
-struct branch<constexpr_bool<false>, Then, Else> : type<Else> {};
+struct branch<constexpr_bool<false>, Then, Else> : type_wrapper<Else> {};
 
 template<typename T, prelude::size_t N>
 consteval T const_value(char const (&arr)[N]) {
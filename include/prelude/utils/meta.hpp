@@ -19,7 +19,7 @@ struct function {
 
 template<typename C, typename R, typename... Args>
 struct member_function {
-    using category = member_function<C>;
+    using category = member_function;
     using class_type = C;
     using return_type = R;
     using parameter_types = type_list<Args...>;
@@ -55,13 +55,13 @@ struct return_value;
 // Type functions
 
 template<typename T>
-struct add_lvalue_reference : type<T&> {};
+struct add_lvalue_reference : type_wrapper<T&> {};
 
 template<typename T>
-struct add_rvalue_reference : type<T&&> {};
+struct add_rvalue_reference : type_wrapper<T&&> {};
 
 template<typename T, typename U>
-struct common_op : type<std::declval<T>() ? std::declval<U>() : std::declval<T>()> {};
+struct common_op : type_wrapper<decltype(true ? std::declval<T>() : std::declval<U>())> {};
 
 template<typename... Ts>
 struct common_type : accumulate<common_op, type_list<Ts...>> {};
@@ -70,40 +70,40 @@ template<typename T>
 struct decay : remove_volatile<T> {};
 
 template<typename T>
-struct decay<T []> : type<T*> {};
+struct decay<T []> : type_wrapper<T*> {};
 
-template<typename T, prelude::size_t>
-struct decay<T [N]> : type<T*> {};
+template<typename T, prelude::size_t N>
+struct decay<T [N]> : type_wrapper<T*> {};
 
 template<typename R, typename... Args>
-struct decay<R (Args...)> : type<R (*)(Args...)> {};
+struct decay<R (Args...)> : type_wrapper<R (*)(Args...)> {};
 
 template<typename R, typename... Args>
-struct decay<R (Args..., ...)> : type<R (*)(Args..., ...)> {};
+struct decay<R (Args..., ...)> : type_wrapper<R (*)(Args..., ...)> {};
 
 template<typename T>
-struct remove_const : type<T> {};
+struct remove_const : type_wrapper<T> {};
 
 template<typename T>
-struct remove_const<T const> : type<T> {};
+struct remove_const<T const> : type_wrapper<T> {};
 
 template<typename T>
-struct remove_const_volatile : remove_volatile<remove_const<T>::type> {};
+struct remove_const_volatile : remove_volatile<typename remove_const<T>::type> {};
 
 template<typename T>
-struct remove_volatile : type<T> {};
+struct remove_volatile : type_wrapper<T> {};
 
 template<typename T>
-struct remove_volatile<T volatile> : type<T> {};
+struct remove_volatile<T volatile> : type_wrapper<T> {};
 
 template<typename T>
-struct remove_reference : type<T> {};
+struct remove_reference : type_wrapper<T> {};
 
 template<typename T>
-struct remove_reference<T&> : type<T> {};
+struct remove_reference<T&> : type_wrapper<T> {};
 
 template<typename T>
-struct remove_reference<T&&> : type<T> {};
+struct remove_reference<T&&> : type_wrapper<T> {};
 
 template<typename FSig>
 struct universal_function<FSig, false> {
@@ -116,7 +116,7 @@ template<typename FSig>
 struct universal_function<FSig, true> {
     using trait_type = function_traits<FSig>;
     using return_type = trait_type::return_type;
-    using parameter_types = typeof<prepend<trait_type::class_type, trait_type::parameter_types>>;
+    using parameter_types = typeof<prepend<typename trait_type::class_type, typename trait_type::parameter_types>>;
 };
 
 // Type traits
@@ -133,103 +133,103 @@ template<typename R, typename... Args>
 struct function_traits<R (Args...)> : trait_tags::function<R, Args...> {};
 
 template<typename R, typename... Args>
-struct function_traits<R (Args..., ...)> : traits_tag::function<R, Args...>, trait_tags::variadic {};
+struct function_traits<R (Args..., ...)> : trait_tags::function<R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename... Args>
 struct function_traits<R (*)(Args...)> : trait_tags::function<R, Args...> {};
 
 template<typename R, typename... Args>
-struct function_traits<R (*)(Args..., ...)> : traits_tag::function<R, Args...>, trait_tags::variadic {};
+struct function_traits<R (*)(Args..., ...)> : trait_tags::function<R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename... Args>
 struct function_traits<R (* const)(Args...)> : trait_tags::function<R, Args...> {};
 
 template<typename R, typename... Args>
-struct function_traits<R (* const)(Args..., ...)> : traits_tag::function<R, Args...>, trait_tags::variadic {};
+struct function_traits<R (* const)(Args..., ...)> : trait_tags::function<R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename... Args>
 struct function_traits<R (* volatile)(Args...)> : trait_tags::function<R, Args...> {};
 
 template<typename R, typename... Args>
-struct function_traits<R (* volatile)(Args..., ...)> : traits_tag::function<R, Args...>, trait_tags::variadic {};
+struct function_traits<R (* volatile)(Args..., ...)> : trait_tags::function<R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename... Args>
 struct function_traits<R (* const volatile)(Args...)> : trait_tags::function<R, Args...> {};
 
 template<typename R, typename... Args>
-struct function_traits<R (* const volatile)(Args..., ...)> : traits_tag::function<R, Args...>, trait_tags::variadic {};
+struct function_traits<R (* const volatile)(Args..., ...)> : trait_tags::function<R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
 struct function_traits<R (C::*)(Args...)> : trait_tags::member_function<C, R, Args...> {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..., ...)> : traits_tag::member_function<C, R, Args...>, trait_tags::variadic {};
+struct function_traits<R (C::*)(Args..., ...)> : trait_tags::member_function<C, R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
 struct function_traits<R (C::*)(Args...) const> : trait_tags::member_function<C const, R, Args...> {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..., ...) const> : traits_tag::member_function<C const, R, Args...>, trait_tags::variadic {};
+struct function_traits<R (C::*)(Args..., ...) const> : trait_tags::member_function<C const, R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
 struct function_traits<R (C::*)(Args...) volatile> : trait_tags::member_function<C volatile, R, Args...> {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..., ...) volatile> : traits_tag::member_function<C volatile, R, Args...>, trait_tags::variadic {};
+struct function_traits<R (C::*)(Args..., ...) volatile> : trait_tags::member_function<C volatile, R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
 struct function_traits<R (C::*)(Args...) const volatile> : trait_tags::member_function<C const volatile, R, Args...> {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..., ...) const volatile> : traits_tag::member_function<C const volatile, R, Args...>, trait_tags::variadic {};
+struct function_traits<R (C::*)(Args..., ...) const volatile> : trait_tags::member_function<C const volatile, R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
 struct function_traits<R (C::*)(Args...) &> : trait_tags::member_function<C&, R, Args...> {};
 
-template<typename R, typename C, typename... Arg>
-struct function_traits<R (C::*)(Args..., ...) &> : traits_tag::member_function<C&, R, Args...>, trait_tags::variadic {};
+template<typename R, typename C, typename... Args>
+struct function_traits<R (C::*)(Args..., ...) &> : trait_tags::member_function<C&, R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
 struct function_traits<R (C::*)(Args...) const&> : trait_tags::member_function<C const&, R, Args...> {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..., ...) const&> : traits_tag::member_function<C const&, R, Args...>, trait_tags::variadic {};
+struct function_traits<R (C::*)(Args..., ...) const&> : trait_tags::member_function<C const&, R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
 struct function_traits<R (C::*)(Args...) volatile&> : trait_tags::member_function<C volatile&, R, Args...> {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..., ...) volatile&> : traits_tag::member_function<C volatile&, R, Args...>, trait_tags::variadic {};
+struct function_traits<R (C::*)(Args..., ...) volatile&> : trait_tags::member_function<C volatile&, R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
 struct function_traits<R (C::*)(Args...) const volatile&> : trait_tags::member_function<C const volatile&, R, Args...> {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..., ...) const volatile&> : traits_tag::member_function<C const volatile&, R, Args...>, trait_tags::variadic {};
+struct function_traits<R (C::*)(Args..., ...) const volatile&> : trait_tags::member_function<C const volatile&, R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..) &&> : trait_tags::member_function<C&&, R, Args...> {};
+struct function_traits<R (C::*)(Args...) &&> : trait_tags::member_function<C&&, R, Args...> {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..., ...) &&> : traits_tag::member_function<C&&, R, Args...>, trait_tags::variadic {};
+struct function_traits<R (C::*)(Args..., ...) &&> : trait_tags::member_function<C&&, R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
 struct function_traits<R (C::*)(Args...) const&&> : trait_tags::member_function<C const&&, R, Args...> {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..., ...) const&&> : traits_tag::member_function<C const&&, R, Args...>, trait_tags::variadic {};
+struct function_traits<R (C::*)(Args..., ...) const&&> : trait_tags::member_function<C const&&, R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
 struct function_traits<R (C::*)(Args...) volatile&&> : trait_tags::member_function<C volatile&&, R, Args...> {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..., ...) volatile&&> : traits_tag::member_function<C volatile&&, R, Args...>, trait_tags::variadic {};
+struct function_traits<R (C::*)(Args..., ...) volatile&&> : trait_tags::member_function<C volatile&&, R, Args...>, trait_tags::variadic {};
 
 template<typename R, typename C, typename... Args>
 struct function_traits<R (C::*)(Args...) const volatile&&> : trait_tags::member_function<C const volatile&&, R, Args...> {};
 
 template<typename R, typename C, typename... Args>
-struct function_traits<R (C::*)(Args..., ...) const volatile&&> : traits_tag::member_function<C const volatile&&, R, Args...>, trait_tags::variadic {};
+struct function_traits<R (C::*)(Args..., ...) const volatile&&> : trait_tags::member_function<C const volatile&&, R, Args...>, trait_tags::variadic {};
 
 #pragma endregion // Overloading Disaster
 
@@ -252,7 +252,7 @@ template<typename T, typename Test = void>
 struct is_default_constructible : constexpr_false {};
 
 template<typename T>
-struct is_default_constructible<T, prelude::void_t<decltype(T())>> {};
+struct is_default_constructible<T, prelude::void_t<decltype(T())>> : constexpr_true {};
 
 template<typename T>
 struct is_function : constexpr_false {};
@@ -276,10 +276,10 @@ template<typename R, typename C>
 struct is_member_pointer<R C::*> : constexpr_true {};
 
 template<typename T, typename Test = void>
-struct is_memeber_function_pointer : constexpr_false {};
+struct is_member_function_pointer : constexpr_false {};
 
 template<typename T>
-struct is_member_function_pointer<T, prelude::void_t<function_traits<T>>> : constexpr_bool<function_traits<T>::is_member_function> {};
+struct is_member_function_pointer<T, prelude::void_t<decltype(function_traits<T>::is_member_function)>> : constexpr_bool<function_traits<T>::is_member_function> {};
 
 template<typename T>
 struct is_pointer : constexpr_false {};
@@ -302,19 +302,19 @@ struct is_same : constexpr_false {};
 template<typename T>
 struct is_same<T, T> : constexpr_true {};
 
-template<prelude::size_t I>
+template<prelude::size_t I, typename R>
 struct nth_argument<I, R ()> : null {};
 
 template<typename R, typename Head, typename... Tail>
-struct nth_argument<0, R (Head, Tail...)> : type<Head> {};
+struct nth_argument<0, R (Head, Tail...)> : type_wrapper<Head> {};
 
 template<prelude::size_t I, typename R, typename Head, typename... Tail>
 struct nth_argument<I, R (Head, Tail...)> : nth_argument<I-1, R (Tail...)> {};
 
 template<typename R, typename... Args>
-struct return_value<R (Args...)> : type<R> {};
+struct return_value<R (Args...)> : type_wrapper<R> {};
 
 template<typename T, typename U>
-concept same_type<T, U> = is_same<T, U>::value;
+concept same_type = is_same<T, U>::value;
 
 } // namespace prelude
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+
+#include "../defs.hpp"
+
+namespace prelude {
+
+// Hint to the processor that we are busy waiting.
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * @brief A test-and-test-and-set spin lock for very short critical sections, such as pushing
+ * onto or popping from a shared free list. Satisfies the BasicLockable requirements, so it can
+ * be used with std::lock_guard.
+ */
+class spin_lock {
+public:
+    constexpr spin_lock() noexcept = default;
+
+    spin_lock(spin_lock const&) = delete;
+
+    spin_lock& operator =(spin_lock const&) = delete;
+
+    void lock() noexcept {
+        while (m_locked.exchange(true, std::memory_order_acquire)) {
+            while (m_locked.load(std::memory_order_relaxed)) {
+                cpu_relax();
+            }
+        }
+    }
+
+    bool try_lock() noexcept {
+        return !m_locked.load(std::memory_order_relaxed) && !m_locked.exchange(true, std::memory_order_acquire);
+    }
+
+    void unlock() noexcept {
+        m_locked.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic<bool> m_locked = false;
+};
+
+} // namespace prelude
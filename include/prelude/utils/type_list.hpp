@@ -28,17 +28,17 @@ struct head;
 template<typename List>
 struct max_element;
 
-template<typename List>
+template<typename List, prelude::size_t N>
 struct max_element_aux;
 
 template<prelude::size_t I, typename List>
-struct nth;
+struct type_nth;
 
 template<typename T, typename List>
 struct prepend;
 
 template<typename List>
-struct size;
+struct type_size;
 
 template<typename List>
 struct tail;
@@ -48,14 +48,18 @@ struct transform;
 
 // Partial specializations for type_list<Ts...>
 
-template<template<typename, typename> class Op, typename... Ts>
-struct accumulate<Op, type_list<Ts...>> : accumulate_aux<Op, type_list<Ts...>, Acc> {};
+// A left fold that starts from the first element; an empty list folds to null.
+template<template<typename, typename> class Op>
+struct accumulate<Op, type_list<>> : null {};
+
+template<template<typename, typename> class Op, typename Head, typename... Tail>
+struct accumulate<Op, type_list<Head, Tail...>> : accumulate_aux<Op, type_list<Tail...>, Head> {};
 
 template<template<typename, typename> class Op, typename Acc>
-struct accumulate_aux<Op, type_list<>, Acc> : type<Acc> {};
+struct accumulate_aux<Op, type_list<>, Acc> : type_wrapper<Acc> {};
 
 template<template<typename, typename> class Op, typename Head, typename... Tail, typename Acc>
-struct accumulate_aux<Op, type_list<Head, Tail...>, Acc> : accumulate<Op, type_list<Tail...>, typeof<Op<Acc, Head>>> {};
+struct accumulate_aux<Op, type_list<Head, Tail...>, Acc> : accumulate_aux<Op, type_list<Tail...>, typeof<Op<Acc, Head>>> {};
 
 template<typename T>
 struct contains<T, type_list<>> : constexpr_false {};
@@ -82,42 +86,42 @@ template<>
 struct head<type_list<>> : null {};
 
 template<typename Head, typename... Tail>
-struct head<type_list<Head, Tail...>> : type<Head> {};
+struct head<type_list<Head, Tail...>> : type_wrapper<Head> {};
 
 template<typename... Ts>
 struct max_element<type_list<Ts...>> : max_element_aux<type_list<Ts...>, 0> {};
 
 template<prelude::size_t N>
-struct max_element_aux<type_list<>> : constexpr_size<N> {};
+struct max_element_aux<type_list<>, N> : constexpr_size<N> {};
 
 template<typename Head, typename... Tail, prelude::size_t N>
-struct max_element_aux<type_list<Head, Tail...>, N> : max_element_aux<type_list<Tail...>, max(N, sizeof(Head))> {};
+struct max_element_aux<type_list<Head, Tail...>, N> : max_element_aux<type_list<Tail...>, (N < sizeof(Head) ? sizeof(Head) : N)> {};
 
 template<prelude::size_t I>
-struct nth<I, type_list<>> : null {};
+struct type_nth<I, type_list<>> : null {};
 
 template<typename Head, typename... Tail>
-struct nth<0, type_list<Head, Tail...>> : type<Head> {};
+struct type_nth<0, type_list<Head, Tail...>> : type_wrapper<Head> {};
 
 template<prelude::size_t I, typename Head, typename... Tail>
-struct nth<I, type_list<Head, Tail...>> : nth<I-1, type_list<Tail...>> {};
+struct type_nth<I, type_list<Head, Tail...>> : type_nth<I-1, type_list<Tail...>> {};
 
 template<typename... Ts>
-struct size<type_list<Ts...>> : constexpr_size<sizeof...(Ts)> {};
+struct type_size<type_list<Ts...>> : constexpr_size<sizeof...(Ts)> {};
 
 template<typename Head, typename... Tail>
-struct prepend<Head, type_list<Tail...>>, type<type_list<Head, Tail...>> {};
+struct prepend<Head, type_list<Tail...>> : type_wrapper<type_list<Head, Tail...>> {};
 
 template<>
 struct tail<type_list<>> : null {};
 
 template<typename Head, typename... Tail>
-struct tail<type_list<Head, Tail...>> : type<type_list<Tail...>> {};
+struct tail<type_list<Head, Tail...>> : type_wrapper<type_list<Tail...>> {};
 
 template<template<typename> class F>
-struct transform<F, type_list<>> : type<type_list<>> {};
+struct transform<F, type_list<>> : type_wrapper<type_list<>> {};
 
 template<template<typename> class F, typename Head, typename... Tail>
-struct transform<F, type_list<Head, Tail...>> : prepend<typeof<F<Head>>, transform<F, type_list<Tail...>>> {};
+struct transform<F, type_list<Head, Tail...>> : prepend<typeof<F<Head>>, typeof<transform<F, type_list<Tail...>>>> {};
 
 } // namespace prelude
\ No newline at end of file
@@ -0,0 +1,441 @@
+// Randomized differential test of the list containers against std::deque, and of soa_list against
+// a std::deque of std::tuples.
+//
+//     g++ -std=c++23 -O1 -g -fsanitize=address,undefined -Iinclude tests/adts_fuzz.cpp -o adts_fuzz
+//     g++ -std=c++23 -O2 -DNDEBUG -Iinclude tests/adts_fuzz.cpp -o adts_fuzz && ./adts_fuzz --bench
+//
+// Every container is driven by the same random mix of pushes, pops, inserts, erases, copies and
+// moves on both ends, and checked element by element against a std::deque doing the same. The
+// elements are long std::strings so that a missed destructor, a double move or a stale slot shows
+// up under the sanitizers and not only as a wrong value. soa_list is checked the same way with two
+// std::string columns around an int column, and with a column type that throws partway through an
+// element, a growth or a copy, after which nothing may leak or be left half-built. --bench cycles ints through queue over
+// its default deque and over a linked queue of node_allocator nodes, at a few queue lengths.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <tuple>
+
+#include "prelude/adts/deque.hpp"
+#include "prelude/adts/list.hpp"
+#include "prelude/adts/queue.hpp"
+#include "prelude/adts/soa_list.hpp"
+#include "prelude/adts/stack.hpp"
+#include "prelude/structs/linked.hpp"
+
+namespace {
+
+constexpr int k_operations = 200'000;
+
+static_assert(prelude::list_type<prelude::array_list<std::string>>);
+static_assert(prelude::list_type<prelude::small_array_list<std::string, 8>>);
+static_assert(prelude::list_type<prelude::deque<std::string>>);
+
+bool g_failed = false;
+
+void check(bool cond, char const* what) {
+    if (!cond && !g_failed) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        g_failed = true;
+    }
+}
+
+std::string make_value(std::mt19937_64& rng) {
+    // Longer than any small-string buffer, so each element owns heap memory.
+    return std::string(24 + rng() % 16, char('a' + rng() % 26)) + std::to_string(rng());
+}
+
+template<typename List>
+bool same(List const& list, std::deque<std::string> const& ref) {
+    if (list.size() != ref.size() || list.empty() != ref.empty()) {
+        return false;
+    }
+    for (auto i = 0uz; i < ref.size(); ++i) {
+        if (list[i] != ref[i]) {
+            return false;
+        }
+    }
+    return ref.empty() || (list.front() == ref.front() && list.back() == ref.back());
+}
+
+template<typename List>
+void fuzz(char const* name, unsigned long long seed) {
+    auto rng = std::mt19937_64(seed);
+    auto list = List();
+    auto ref = std::deque<std::string>();
+
+    for (int op = 0; op < k_operations; ++op) {
+        // Alternate between growing to a few hundred elements and hovering around a dozen.
+        auto const limit = (op / 2000) % 2 == 0 ? 300uz : 12uz;
+        auto const kind = rng() % (ref.size() < limit ? 10 : 13);
+        auto const at = ref.empty() ? 0 : rng() % (ref.size() + 1);
+        switch (kind) {
+        case 0: case 1: case 10: {
+            auto value = make_value(rng);
+            ref.push_back(value);
+            list.push_back(static_cast<std::string&&>(value));
+            break;
+        }
+        case 2: case 11: {
+            auto const value = make_value(rng);
+            ref.push_front(value);
+            list.push_front(value);
+            break;
+        }
+        case 3: {
+            auto const value = make_value(rng);
+            ref.insert(ref.begin() + at, value);
+            list.insert(list.cbegin() + at, value);
+            break;
+        }
+        case 4: case 12:
+            if (!ref.empty()) {
+                auto const i = at % ref.size();
+                ref.erase(ref.begin() + i);
+                list.erase(list.cbegin() + i);
+            }
+            break;
+        case 5:
+            if (!ref.empty()) {
+                ref.pop_back();
+                list.pop_back();
+            }
+            break;
+        case 6:
+            if (!ref.empty()) {
+                ref.pop_front();
+                list.pop_front();
+            }
+            break;
+        case 7:
+            // Push a copy of an element of the list itself.
+            if (!ref.empty()) {
+                auto const i = at % ref.size();
+                ref.push_back(ref[i]);
+                list.push_back(list[i]);
+            }
+            break;
+        case 8: {
+            auto copy = list;
+            list = List();
+            list = static_cast<List&&>(copy);
+            break;
+        }
+        case 9:
+            if (rng() % 64 == 0) {
+                ref.clear();
+                list.clear();
+            }
+            else if (rng() % 16 == 0) {
+                if constexpr (requires { list.shrink_to_fit(); }) {
+                    list.shrink_to_fit();
+                }
+            }
+            else if (!ref.empty()) {
+                auto const i = at % ref.size();
+                ref[i] = make_value(rng);
+                list[i] = ref[i];
+            }
+            break;
+        }
+        if (!same(list, ref)) {
+            std::fprintf(stderr, "FAILED: %s diverged from std::deque at operation %d\n", name, op);
+            g_failed = true;
+            return;
+        }
+    }
+    std::printf("%s: %d operations, final size %zu\n", name, k_operations, ref.size());
+}
+
+using soa_type = prelude::soa_list<std::string, int, std::string>;
+using soa_ref_type = std::deque<std::tuple<std::string, int, std::string>>;
+
+bool same(soa_type const& list, soa_ref_type const& ref) {
+    if (list.size() != ref.size() || list.column<1>().size() != ref.size()) {
+        return false;
+    }
+    for (auto i = 0uz; i < ref.size(); ++i) {
+        auto const row = list[i];
+        auto const& [name, id, tag] = ref[i];
+        if (prelude::get<0>(row) != name || prelude::get<1>(row) != id || prelude::get<2>(row) != tag || list.column<1>()[i] != id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void soa_fuzz() {
+    auto rng = std::mt19937_64(5);
+    auto list = soa_type();
+    auto ref = soa_ref_type();
+    for (int op = 0; op < k_operations / 4; ++op) {
+        auto const limit = (op / 2000) % 2 == 0 ? 300uz : 12uz;
+        auto const at = ref.empty() ? 0 : rng() % ref.size();
+        switch (rng() % (ref.size() < limit ? 7 : 9)) {
+        case 0: case 1: case 7: {
+            auto name = make_value(rng);
+            auto tag = make_value(rng);
+            auto const id = int(rng() % 1000);
+            ref.emplace_back(name, id, tag);
+            list.push_back(static_cast<std::string&&>(name), id, static_cast<std::string&&>(tag));
+            break;
+        }
+        case 2:
+            // Copy an element of the list itself, which must survive the list growing under it.
+            if (!ref.empty()) {
+                ref.push_back(ref[at]);
+                auto const row = list[at];
+                list.emplace_back(prelude::get<0>(row), prelude::get<1>(row), prelude::get<2>(row));
+            }
+            break;
+        case 3: case 8:
+            if (!ref.empty()) {
+                ref.erase(ref.begin() + long(at));
+                list.erase(at);
+            }
+            break;
+        case 4:
+            if (!ref.empty()) {
+                auto const last = at + rng() % (ref.size() - at + 1);
+                ref.erase(ref.begin() + long(at), ref.begin() + long(last));
+                list.erase(at, last);
+            }
+            break;
+        case 5:
+            if (!ref.empty()) {
+                ref.pop_back();
+                list.pop_back();
+            }
+            break;
+        case 6:
+            if (rng() % 32 == 0) {
+                ref.clear();
+                list.clear();
+            }
+            else if (rng() % 4 == 0) {
+                auto copy = list;
+                list = soa_type();
+                list = static_cast<soa_type&&>(copy);
+            }
+            else {
+                for (auto& id : list.column<1>()) {
+                    ++id;
+                }
+                for (auto& row : ref) {
+                    ++std::get<1>(row);
+                }
+            }
+            break;
+        }
+        if (!same(list, ref)) {
+            std::fprintf(stderr, "FAILED: soa_list diverged from std::deque at operation %d\n", op);
+            g_failed = true;
+            return;
+        }
+    }
+    std::printf("soa_list: %d operations, final size %zu\n", k_operations / 4, ref.size());
+}
+
+// Counts its live instances, and throws from a constructor once the countdown reaches zero.
+struct fragile {
+    static inline int countdown = 0;
+    static inline int live = 0;
+
+    int value;
+
+    fragile(int v)
+        : value(v) {
+
+        fragile::tick();
+    }
+
+    fragile(fragile const& other)
+        : value(other.value) {
+
+        fragile::tick();
+    }
+
+    // Relocation on growth moves, and must not throw.
+    fragile(fragile&& other) noexcept
+        : value(other.value) {
+
+        ++live;
+    }
+
+    ~fragile() {
+        --live;
+    }
+
+    static void tick() {
+        if (--countdown == 0) {
+            throw value_error();
+        }
+        ++live;
+    }
+
+    struct value_error {};
+};
+
+// The std::string columns either side of the throwing one show a leak under the sanitizers.
+void soa_throwing() {
+    using list_type = prelude::soa_list<std::string, fragile, std::string>;
+    auto rng = std::mt19937_64(6);
+    for (int round = 0; round < 200; ++round) {
+        auto list = list_type();
+        auto const n = 1 + rng() % 40;
+        fragile::countdown = -1;
+        for (auto i = 0uz; i < n; ++i) {
+            list.emplace_back(make_value(rng), int(i), make_value(rng));
+        }
+        fragile::countdown = 1 + int(rng() % (2 * n));
+        auto const before = list.size();
+        try {
+            if (round % 2 == 0) {
+                auto copy = list;
+                check(copy.size() == before, "soa_list copy lost rows");
+            }
+            else {
+                while (true) {
+                    list.emplace_back(make_value(rng), 0, make_value(rng));
+                }
+            }
+        }
+        catch (fragile::value_error const&) {
+        }
+        fragile::countdown = -1;
+        check(fragile::live == int(list.size()), "soa_list leaked or lost an element when a column threw");
+        check(round % 2 == 1 || list.size() == before, "a throwing copy changed the source");
+        for (auto i = 0uz; i < before; ++i) {
+            check(prelude::get<1>(list[i]).value == int(i), "a throwing emplace_back disturbed earlier rows");
+        }
+    }
+}
+
+// The adapters over their default containers: LIFO and FIFO order over a few thousand elements.
+void adapters() {
+    auto stack = prelude::stack<int>();
+    auto queue = prelude::queue<int>();
+    for (int i = 0; i < 5000; ++i) {
+        stack.push(i);
+        queue.push(i);
+    }
+    for (int i = 0; i < 5000; ++i) {
+        if (stack.top() != 4999 - i || queue.top() != i) {
+            std::fprintf(stderr, "FAILED: adapter order at %d\n", i);
+            g_failed = true;
+            return;
+        }
+        stack.pop();
+        queue.pop();
+    }
+    if (!stack.is_empty() || !queue.is_empty()) {
+        std::fprintf(stderr, "FAILED: adapters not empty after draining\n");
+        g_failed = true;
+    }
+}
+
+// A FIFO of singly_linked_nodes, one allocation per element: what queue was before deque.
+template<typename T>
+class node_queue {
+    using node_type = prelude::singly_linked_node<T>;
+
+public:
+    node_queue() = default;
+
+    node_queue(node_queue const&) = delete;
+
+    ~node_queue() {
+        while (!this->is_empty()) {
+            this->pop();
+        }
+    }
+
+    bool is_empty() const noexcept {
+        return m_head == nullptr;
+    }
+
+    T& top() {
+        return m_head->data;
+    }
+
+    void push(T const& value) {
+        auto* node = m_alloc.new_object(value, nullptr);
+        if (m_tail != nullptr) {
+            m_tail->next = node;
+        }
+        else {
+            m_head = node;
+        }
+        m_tail = node;
+    }
+
+    void pop() {
+        auto* node = m_head;
+        m_head = node->next;
+        if (m_head == nullptr) {
+            m_tail = nullptr;
+        }
+        m_alloc.deallocate(node, 1);
+    }
+
+private:
+    prelude::node_allocator<node_type> m_alloc;
+    node_type* m_head = nullptr;
+    node_type* m_tail = nullptr;
+};
+
+// Fill the queue to length, then pop one and push one for ops steps, then drain.
+template<typename Queue>
+double time_cycle(int length, int ops, unsigned long long& checksum) {
+    auto const start = std::chrono::steady_clock::now();
+    auto queue = Queue();
+    for (int i = 0; i < length; ++i) {
+        queue.push(i);
+    }
+    for (int i = 0; i < ops; ++i) {
+        checksum += unsigned(queue.top());
+        queue.pop();
+        queue.push(i);
+    }
+    while (!queue.is_empty()) {
+        checksum += unsigned(queue.top());
+        queue.pop();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void bench() {
+    constexpr int ops = 1 << 24;
+    for (int length : { 16, 4096, 1 << 20 }) {
+        unsigned long long sums[2] = {};
+        auto const ring = time_cycle<prelude::queue<int>>(length, ops, sums[0]);
+        auto const nodes = time_cycle<node_queue<int>>(length, ops, sums[1]);
+        if (sums[0] != sums[1]) {
+            std::fprintf(stderr, "FAILED: queues disagree at length %d\n", length);
+            g_failed = true;
+        }
+        std::printf("16M int pop+push at length %d: deque %.0f ms, linked nodes %.0f ms\n", length, ring, nodes);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    fuzz<prelude::array_list<std::string>>("array_list", 1);
+    // Small inline capacities keep the list crossing between inline and heap storage.
+    fuzz<prelude::small_array_list<std::string, 1>>("small_array_list<1>", 2);
+    fuzz<prelude::small_array_list<std::string, 8>>("small_array_list<8>", 3);
+    fuzz<prelude::deque<std::string>>("deque", 4);
+    soa_fuzz();
+    soa_throwing();
+    adapters();
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        bench();
+    }
+    return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
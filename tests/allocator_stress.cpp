@@ -0,0 +1,413 @@
+// Stress test of the node pool allocator, the monotonic arena, the allocation statistics and the
+// sized and aligned heap paths, plus a timing run.
+//
+//     g++ -std=c++23 -O1 -g -fsanitize=address,undefined -Iinclude tests/allocator_stress.cpp -o allocator_stress
+//     g++ -std=c++23 -O1 -g -fsanitize=thread -Iinclude tests/allocator_stress.cpp -o allocator_stress
+//     g++ -std=c++23 -O2 -DNDEBUG -Iinclude tests/allocator_stress.cpp -o allocator_stress && ./allocator_stress --bench
+//
+// node_allocator blocks are filled with a pattern derived from their address and checked before
+// they are freed, in random order, so two live nodes sharing storage or a block handed out twice
+// shows up as a corrupted pattern. The threaded round passes batches of nodes round a ring of
+// threads so that every node is freed on a different thread from the one that allocated it, which
+// keeps magazines flowing through the depot. Arena allocations of mixed size and alignment are
+// checked the same way across resets, and nested arena_scopes must install and restore the
+// default arena. Statistics are built in, and their totals are checked after threads have
+// recorded and exited. The global operator new and delete are replaced to see which overload
+// basic_allocator reaches and with what size and alignment. --bench builds, traverses and tears
+// down a 1M-node list with node_allocator and basic_allocator, and times allocate/free churn on 1
+// to 2x hardware_concurrency threads.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#define PRELUDE_ALLOCATION_STATS 1
+
+#include "prelude/structs/linked.hpp"
+#include "prelude/utils/allocation_stats.hpp"
+#include "prelude/utils/allocator.hpp"
+
+namespace {
+
+std::atomic<bool> g_failed = false;
+
+// What the last operator new or delete on this thread was asked for. A zero alignment stands for
+// an overload without std::align_val_t, and a zero size for an unsized delete.
+struct heap_call {
+    prelude::size_t size;
+    prelude::size_t align;
+};
+
+thread_local heap_call g_last_new = {};
+thread_local heap_call g_last_delete = {};
+
+void check(bool cond, char const* what) {
+    if (!cond && !g_failed.exchange(true)) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+    }
+}
+
+using node_type = prelude::singly_linked_node<unsigned long long>;
+
+unsigned long long tag(node_type const* node) {
+    return reinterpret_cast<unsigned long long>(node) * 0x9e3779b97f4a7c15ull;
+}
+
+void node_round(std::mt19937_64& rng) {
+    auto alloc = prelude::node_allocator<node_type>();
+    auto live = std::vector<node_type*>();
+    for (int op = 0; op < 200'000 && !g_failed; ++op) {
+        if (live.empty() || rng() % 3 != 0) {
+            auto* node = alloc.new_object(0ull, nullptr);
+            check(reinterpret_cast<unsigned long long>(node) % alignof(node_type) == 0, "node is misaligned");
+            node->data = tag(node);
+            live.push_back(node);
+        }
+        else {
+            auto const i = rng() % live.size();
+            std::swap(live[i], live.back());
+            check(live.back()->data == tag(live.back()), "node storage was shared or reused while live");
+            alloc.deallocate(live.back(), 1);
+            live.pop_back();
+        }
+    }
+    for (auto* node : live) {
+        check(node->data == tag(node), "node storage was shared or reused while live");
+        alloc.deallocate(node, 1);
+    }
+}
+
+// Each thread allocates batches, hands them to its successor in the ring and frees whatever its
+// predecessor handed it.
+void threaded_round() {
+    constexpr int threads = 4;
+    constexpr int batches = 200;
+    constexpr int batch_size = 300;
+    struct mailbox {
+        std::mutex lock;
+        std::vector<std::vector<node_type*>> batches;
+    };
+    auto boxes = std::vector<mailbox>(threads);
+    auto workers = std::vector<std::thread>();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            auto alloc = prelude::node_allocator<node_type>();
+            int received = 0;
+            auto drain = [&] {
+                auto inbox = std::vector<std::vector<node_type*>>();
+                {
+                    auto guard = std::lock_guard(boxes[t].lock);
+                    inbox.swap(boxes[t].batches);
+                }
+                for (auto& batch : inbox) {
+                    for (auto* node : batch) {
+                        check(node->data == tag(node), "node storage was shared or reused while live");
+                        alloc.deallocate(node, 1);
+                    }
+                    ++received;
+                }
+            };
+            // Free before ever allocating on this thread, which must not set up a cache.
+            if (t == 0) {
+                node_type* node = nullptr;
+                std::thread([&] { node = alloc.new_object(0ull, nullptr); }).join();
+                alloc.deallocate(node, 1);
+            }
+            for (int b = 0; b < batches; ++b) {
+                auto batch = std::vector<node_type*>();
+                for (int i = 0; i < batch_size; ++i) {
+                    auto* node = alloc.new_object(0ull, nullptr);
+                    node->data = tag(node);
+                    batch.push_back(node);
+                }
+                {
+                    auto guard = std::lock_guard(boxes[(t + 1) % threads].lock);
+                    boxes[(t + 1) % threads].batches.push_back(static_cast<std::vector<node_type*>&&>(batch));
+                }
+                drain();
+            }
+            while (received < batches) {
+                drain();
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+struct stats_probe {
+    unsigned char bytes[48];
+};
+
+// Threads record into their own counter blocks and exit, folding them into the retired total; the
+// merged snapshot must still add up.
+void stats_round() {
+    using alloc_type = prelude::instrumented_allocator<prelude::basic_allocator<stats_probe>>;
+    using node_alloc_type = prelude::instrumented_allocator<prelude::node_allocator<node_type>>;
+    constexpr int threads = 4;
+    constexpr prelude::size_t per_thread = 1'000;
+    auto workers = std::vector<std::thread>();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([] {
+            auto alloc = alloc_type();
+            auto node_alloc = node_alloc_type();
+            auto held = std::vector<std::pair<stats_probe*, prelude::size_t>>();
+            auto nodes = std::vector<node_type*>();
+            for (prelude::size_t i = 1; i <= per_thread; ++i) {
+                held.emplace_back(alloc.allocate(i), i);
+                nodes.push_back(node_alloc.new_object(0ull, nullptr));
+            }
+            for (auto [p, n] : held) {
+                alloc.deallocate(p, n);
+            }
+            for (auto* node : nodes) {
+                node_alloc.deallocate(node, 1);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    auto const snap = alloc_type::snapshot();
+    auto const held_bytes = prelude::ssize_t(per_thread * (per_thread + 1) / 2 * sizeof(stats_probe));
+    check(snap.allocations == threads * per_thread, "allocation count is off");
+    check(snap.deallocations == threads * per_thread, "deallocation count is off");
+    check(snap.live_bytes == 0, "live bytes did not return to zero");
+    check(snap.peak_bytes + threads * prelude::allocation_stats_base::k_flush_bytes >= held_bytes, "peak is below what one thread held");
+    check(snap.peak_bytes <= threads * held_bytes, "peak is above what all threads held");
+    auto histogram_total = prelude::size_t(0);
+    for (auto count : snap.histogram) {
+        histogram_total += count;
+    }
+    check(histogram_total == snap.allocations, "histogram does not add up to the allocation count");
+
+    auto const nodes = node_alloc_type::snapshot();
+    check(nodes.allocations == threads * per_thread && nodes.live_bytes == 0, "node allocator totals are off");
+    check(nodes.histogram[4] == nodes.allocations, "16-byte nodes landed outside the (8, 16] bucket");
+
+    auto seen = 0;
+    prelude::allocation_stats_registry::for_each([&](prelude::allocation_snapshot const& entry) {
+        seen += entry.name == snap.name || entry.name == nodes.name;
+    });
+    check(seen == 2, "registry is missing an allocator type");
+}
+
+struct alignas(prelude::k_cache_line_size) padded_counter {
+    long value;
+};
+
+void heap_round() {
+    auto ints = prelude::basic_allocator<int>();
+    auto* p = ints.allocate(10);
+    check(g_last_new.size == 10 * sizeof(int) && g_last_new.align == 0, "plain allocate took the wrong operator new");
+    ints.deallocate(p, 10);
+    check(g_last_delete.size == 10 * sizeof(int) && g_last_delete.align == 0, "deallocate did not use sized delete");
+
+    auto counters = prelude::basic_allocator<padded_counter>();
+    auto* c = counters.allocate(3);
+    check(g_last_new.size == 3 * sizeof(padded_counter) && g_last_new.align == alignof(padded_counter), "over-aligned allocate did not pass its alignment");
+    check(reinterpret_cast<unsigned long long>(c) % alignof(padded_counter) == 0, "over-aligned storage is misaligned");
+    for (int i = 0; i < 3; ++i) {
+        c[i].value = i;
+    }
+    counters.deallocate(c, 3);
+    check(g_last_delete.size == 3 * sizeof(padded_counter) && g_last_delete.align == alignof(padded_counter), "over-aligned deallocate did not pass size and alignment");
+
+    for (prelude::size_t n = 1; n < 100; ++n) {
+        auto [q, count] = ints.allocate_at_least(n);
+        check(count >= n, "allocate_at_least returned too few objects");
+        check(g_last_new.size == count * sizeof(int), "allocate_at_least did not ask for the slack it reports");
+        // Under ASan, touching storage past what was requested would be reported.
+        for (prelude::size_t i = 0; i < count; ++i) {
+            q[i] = int(i);
+        }
+        ints.deallocate(q, count);
+        check(g_last_delete.size == count * sizeof(int), "allocate_at_least storage was freed with the wrong size");
+    }
+    auto [d, count] = counters.allocate_at_least(2);
+    check(count == 2, "over-aligned allocate_at_least assumed slack it cannot know about");
+    counters.deallocate(d, count);
+
+    auto nodes = prelude::node_allocator<padded_counter>();
+    auto* node = nodes.new_object(5l);
+    check(reinterpret_cast<unsigned long long>(node) % alignof(padded_counter) == 0, "over-aligned pool node is misaligned");
+    nodes.deallocate(node, 1);
+}
+
+void arena_round(std::mt19937_64& rng) {
+    alignas(prelude::k_cache_line_size) unsigned char buffer[1024];
+    auto arena = prelude::monotonic_arena(buffer, sizeof(buffer));
+    for (int pass = 0; pass < 4 && !g_failed; ++pass) {
+        auto blocks = std::vector<std::pair<unsigned char*, prelude::size_t>>();
+        for (int i = 0; i < 2'000; ++i) {
+            auto const size = 1 + rng() % 200;
+            auto const align = prelude::size_t(1) << (rng() % 7);
+            auto* p = static_cast<unsigned char*>(arena.allocate(size, align));
+            check(reinterpret_cast<unsigned long long>(p) % align == 0, "arena allocation is misaligned");
+            std::memset(p, int(blocks.size() % 251), size);
+            blocks.emplace_back(p, size);
+        }
+        for (prelude::size_t i = 0; i < blocks.size(); ++i) {
+            auto [p, size] = blocks[i];
+            check(std::all_of(p, p + size, [&](unsigned char c) { return c == i % 251; }), "arena allocations overlap");
+        }
+        arena.reset();
+        check(arena.allocate(1, 1) == buffer, "reset did not rewind to the initial buffer");
+        arena.reset();
+    }
+
+    auto outer = prelude::monotonic_arena();
+    auto inner = prelude::monotonic_arena();
+    check(prelude::arena_allocator<int>().arena() == nullptr, "an arena is installed outside any scope");
+    {
+        auto scope = prelude::arena_scope(outer);
+        check(prelude::arena_allocator<int>().arena() == &outer, "arena_scope did not install its arena");
+        {
+            auto nested = prelude::arena_scope(inner);
+            auto alloc = prelude::arena_allocator<node_type>();
+            check(alloc.arena() == &inner, "a nested arena_scope did not take over");
+            auto* node = alloc.new_object(7ull, nullptr);
+            check(node->data == 7, "arena node lost its value");
+            check(prelude::arena_allocator<int>(alloc).arena() == &inner, "rebinding lost the arena");
+        }
+        check(prelude::arena_allocator<int>().arena() == &outer, "a nested arena_scope did not restore the outer one");
+    }
+    check(prelude::arena_allocator<int>().arena() == nullptr, "arena_scope did not restore the empty state");
+}
+
+template<typename Alloc>
+void time_list(char const* name, prelude::size_t n) {
+    auto alloc = Alloc();
+    auto const start = std::chrono::steady_clock::now();
+    node_type* head = nullptr;
+    for (prelude::size_t i = 0; i < n; ++i) {
+        head = alloc.new_object(i, head);
+    }
+    auto const built = std::chrono::steady_clock::now();
+    auto sum = 0ull;
+    for (auto* it = head; it != nullptr; it = it->next) {
+        sum += it->data;
+    }
+    auto const traversed = std::chrono::steady_clock::now();
+    while (head != nullptr) {
+        auto* next = head->next;
+        alloc.deallocate(head, 1);
+        head = next;
+    }
+    auto const done = std::chrono::steady_clock::now();
+    check(sum == n * (n - 1) / 2, "list traversal lost nodes");
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::printf("%s: build %.1f ms, traverse %.1f ms, teardown %.1f ms\n", name, ms(start, built), ms(built, traversed), ms(traversed, done));
+}
+
+// Every thread keeps a window of live nodes and replaces a random one per step. Returns the total
+// number of allocate/free pairs per microsecond.
+template<typename Alloc>
+double time_churn(unsigned threads) {
+    constexpr int steps = 1'000'000;
+    constexpr int window = 256;
+    auto const start = std::chrono::steady_clock::now();
+    auto workers = std::vector<std::thread>();
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([t] {
+            auto alloc = Alloc();
+            auto rng = std::mt19937(t);
+            node_type* live[window];
+            for (auto& node : live) {
+                node = alloc.new_object(0ull, nullptr);
+            }
+            for (int i = 0; i < steps; ++i) {
+                auto& node = live[rng() % window];
+                alloc.deallocate(node, 1);
+                node = alloc.new_object(0ull, nullptr);
+            }
+            for (auto* node : live) {
+                alloc.deallocate(node, 1);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto const us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return double(threads) * steps / us;
+}
+
+void bench() {
+    constexpr prelude::size_t n = 1 << 20;
+    time_list<prelude::node_allocator<node_type>>("1M nodes, node_allocator", n);
+    time_list<prelude::basic_allocator<node_type>>("1M nodes, basic_allocator", n);
+
+    auto const cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= 2 * cores; threads *= 2) {
+        auto const pool = time_churn<prelude::node_allocator<node_type>>(threads);
+        auto const heap = time_churn<prelude::basic_allocator<node_type>>(threads);
+        std::printf("%u threads, alloc+free per us: node_allocator %.1f, basic_allocator %.1f\n", threads, pool, heap);
+    }
+}
+
+} // namespace
+
+// Kept out of line: once malloc and free are inlined into basic_allocator, GCC warns that they do
+// not match the operator new and delete it sees called.
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    g_last_new = { size, 0 };
+    if (auto* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void* operator new(std::size_t size, std::align_val_t align) {
+    auto const a = static_cast<std::size_t>(align);
+    g_last_new = { size, a };
+    if (auto* p = std::aligned_alloc(a, (size + a - 1) / a * a)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept {
+    g_last_delete = { 0, 0 };
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::size_t size) noexcept {
+    g_last_delete = { size, 0 };
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::align_val_t align) noexcept {
+    g_last_delete = { 0, static_cast<std::size_t>(align) };
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::size_t size, std::align_val_t align) noexcept {
+    g_last_delete = { size, static_cast<std::size_t>(align) };
+    std::free(p);
+}
+
+int main(int argc, char** argv) {
+    auto rng = std::mt19937_64(1);
+    node_round(rng);
+    threaded_round();
+    stats_round();
+    heap_round();
+    arena_round(rng);
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        bench();
+    }
+    return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+// Randomized differential test of btree_map against std::map, plus a timing run.
+//
+//     g++ -std=c++23 -O1 -g -fsanitize=address,undefined -Iinclude tests/btree_map_fuzz.cpp -o btree_fuzz
+//     g++ -std=c++23 -O2 -DNDEBUG -msse4.2 -Iinclude tests/btree_map_fuzz.cpp -o btree_fuzz && ./btree_fuzz --bench
+//
+// A map with small nodes, so that it splits and grows tall quickly, and one with the default
+// cache-line-sized nodes are driven by random inserts, assignments, erases, lookups and range scans
+// and checked against a std::map; every few thousand operations the whole map is compared, copied,
+// and rebuilt with from_sorted_range. --bench times insert, point lookup and a 64-entry range scan
+// over 1M random int keys against std::map, a red-black tree with one node per key.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "prelude/structs/btree_map.hpp"
+
+namespace {
+
+static_assert(alignof(prelude::btree_map<int, int>::leaf_type) == prelude::k_cache_line_size);
+static_assert(sizeof(prelude::btree_map<int, int>::leaf_type) == prelude::k_btree_node_size);
+static_assert(sizeof(prelude::btree_map<int, int>::inner_type) == prelude::k_btree_node_size);
+
+bool g_failed = false;
+
+void check(bool cond, char const* what) {
+    if (!cond && !g_failed) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        g_failed = true;
+    }
+}
+
+template<typename Map>
+bool same(Map const& map, std::map<long, long> const& ref) {
+    if (map.size() != ref.size()) {
+        return false;
+    }
+    auto it = map.begin();
+    for (auto const& [key, value] : ref) {
+        if (it == map.end() || (*it).key != key || (*it).value != value) {
+            return false;
+        }
+        ++it;
+    }
+    return it == map.end();
+}
+
+template<typename Map>
+void fuzz(char const* name, std::mt19937_64& rng) {
+    auto map = Map();
+    auto ref = std::map<long, long>();
+    for (int op = 0; op < 100'000 && !g_failed; ++op) {
+        auto const key = long(rng() % 5'000) - 2'500;
+        auto const value = long(rng());
+        switch (rng() % 8) {
+        case 0: case 1: case 2:
+            check(map.insert(key, value) == ref.emplace(key, value).second, "insert disagreed on presence");
+            break;
+        case 3:
+            check(map.insert_or_assign(key, value) == ref.insert_or_assign(key, value).second, "insert_or_assign disagreed on presence");
+            break;
+        case 4:
+            check(map.erase(key) == (ref.erase(key) == 1), "erase disagreed on presence");
+            break;
+        case 5: {
+            auto const* found = map.find(key);
+            auto const expected = ref.find(key);
+            check(expected == ref.end() ? found == nullptr : found != nullptr && *found == expected->second, "find disagreed");
+            break;
+        }
+        default: {
+            auto it = map.lower_bound(key);
+            auto expected = ref.lower_bound(key);
+            for (int i = 0; i < 16 && expected != ref.end(); ++i, ++it, ++expected) {
+                check(it != map.end() && (*it).key == expected->first && (*it).value == expected->second, "range scan diverged");
+            }
+            check(expected != ref.end() || it == map.end(), "range scan ran past the end");
+            break;
+        }
+        }
+        if (op % 5'000 == 4'999) {
+            if (!same(map, ref)) {
+                std::fprintf(stderr, "FAILED: %s diverged from std::map at operation %d\n", name, op);
+                g_failed = true;
+            }
+            auto copy = map;
+            check(same(copy, ref), "copy diverged");
+            auto entries = std::vector<std::pair<long, long>>(ref.begin(), ref.end());
+            map = Map::from_sorted_range(entries.begin(), entries.end());
+            check(same(map, ref), "from_sorted_range diverged");
+        }
+    }
+    std::printf("%s: final size %zu\n", name, std::size_t(ref.size()));
+}
+
+template<typename F>
+double time_ms(F&& f) {
+    auto const start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void bench(std::mt19937_64& rng) {
+    constexpr int n = 1 << 20;
+    constexpr int scan = 64;
+    auto keys = std::vector<int>(n);
+    for (auto& key : keys) {
+        key = int(rng() >> 33);
+    }
+    auto probes = std::vector<int>(n);
+    for (auto& probe : probes) {
+        probe = keys[rng() % n];
+    }
+
+    auto tree = prelude::btree_map<int, int>();
+    auto ref = std::map<int, int>();
+    long long sums[2] = {};
+    auto const tree_insert = time_ms([&] {
+        for (auto key : keys) {
+            tree.insert(key, key);
+        }
+    });
+    auto const ref_insert = time_ms([&] {
+        for (auto key : keys) {
+            ref.emplace(key, key);
+        }
+    });
+    auto const tree_find = time_ms([&] {
+        for (auto probe : probes) {
+            sums[0] += *tree.find(probe);
+        }
+    });
+    auto const ref_find = time_ms([&] {
+        for (auto probe : probes) {
+            sums[1] += ref.find(probe)->second;
+        }
+    });
+    auto const tree_scan = time_ms([&] {
+        for (int i = 0; i < n / scan; ++i) {
+            auto it = tree.lower_bound(probes[std::size_t(i)]);
+            for (int j = 0; j < scan && it != tree.end(); ++j, ++it) {
+                sums[0] += (*it).value;
+            }
+        }
+    });
+    auto const ref_scan = time_ms([&] {
+        for (int i = 0; i < n / scan; ++i) {
+            auto it = ref.lower_bound(probes[std::size_t(i)]);
+            for (int j = 0; j < scan && it != ref.end(); ++j, ++it) {
+                sums[1] += it->second;
+            }
+        }
+    });
+    check(sums[0] == sums[1], "btree_map and std::map disagree");
+    std::printf("1M random ints, btree_map / std::map: insert %.0f / %.0f ms, lookup %.0f / %.0f ms, %d-entry scans %.0f / %.0f ms\n",
+        tree_insert, ref_insert, tree_find, ref_find, scan, tree_scan, ref_scan);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto rng = std::mt19937_64(20);
+    fuzz<prelude::btree_map<long, long, 3, 2>>("btree_map<3, 2>", rng);
+    fuzz<prelude::btree_map<long, long, 5, 4>>("btree_map<5, 4>", rng);
+    fuzz<prelude::btree_map<long, long>>("btree_map", rng);
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        bench(rng);
+    }
+    return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
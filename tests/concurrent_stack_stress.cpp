@@ -0,0 +1,82 @@
+// Multi-threaded stress test for concurrent_stack.
+//
+//     g++ -std=c++23 -O1 -g -fsanitize=thread -Iinclude tests/concurrent_stack_stress.cpp -o stack_stress
+//     g++ -std=c++23 -O1 -g -fsanitize=address,undefined -Iinclude tests/concurrent_stack_stress.cpp -o stack_stress
+//
+// Every thread pushes its own range of values and pops as it goes, so pops race with pushes into
+// memory the epoch domain has just reclaimed. At the end every value must have been popped exactly
+// once: the count and the sum of the popped values are checked against what was pushed. The
+// elements are std::strings so that a node freed while another thread still reads it, or destroyed
+// twice, shows up under the sanitizers.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "prelude/adts/stack.hpp"
+
+namespace {
+
+constexpr int k_threads = 4;
+constexpr long k_per_thread = 50'000;
+
+std::atomic<bool> g_failed = false;
+
+void check(bool cond, char const* what) {
+    if (!cond && !g_failed.exchange(true)) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+    }
+}
+
+} // namespace
+
+int main() {
+    using stack_type = prelude::concurrent_stack<std::string>;
+    auto stack = stack_type();
+    auto pushed = std::atomic<long>(0);
+    auto popped = std::atomic<long>(0);
+    auto count = std::atomic<long>(0);
+
+    auto consume = [&](std::string const& out) {
+        popped += std::stol(out);
+        ++count;
+    };
+
+    auto pool = std::vector<std::thread>();
+    for (int t = 0; t < k_threads; ++t) {
+        pool.emplace_back([&, t] {
+            for (long i = 0; i < k_per_thread; ++i) {
+                auto const value = long(t) * k_per_thread + i + 1;
+                stack.push(std::to_string(value) + std::string(24, ' '));
+                pushed += value;
+                // Every other pop goes through pop_node and retire_node instead of try_pop.
+                if (i % 2 == 0) {
+                    auto out = std::string();
+                    if (stack.try_pop(out)) {
+                        consume(out);
+                    }
+                }
+                else if (auto* node = stack.pop_node()) {
+                    consume(node->data);
+                    prelude::epoch_domain::retire_node<stack_type::node_type, stack_type::allocator_type>(node);
+                }
+            }
+        });
+    }
+    for (auto& th : pool) {
+        th.join();
+    }
+    auto out = std::string();
+    while (stack.try_pop(out)) {
+        consume(out);
+    }
+
+    check(count == k_threads * k_per_thread, "concurrent_stack lost or duplicated a node");
+    check(pushed == popped, "concurrent_stack returned wrong values");
+    check(stack.is_empty(), "concurrent_stack not empty after draining");
+    std::printf("concurrent_stack: %d threads, %ld values\n", k_threads, count.load());
+    return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
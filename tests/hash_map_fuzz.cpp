@@ -0,0 +1,194 @@
+// Randomized differential test of hash_map against std::unordered_map, plus a timing run.
+//
+//     g++ -std=c++23 -O1 -g -fsanitize=address,undefined -Iinclude tests/hash_map_fuzz.cpp -o hash_fuzz
+//     g++ -std=c++23 -O2 -DNDEBUG -Iinclude tests/hash_map_fuzz.cpp -o hash_fuzz && ./hash_fuzz --bench
+//
+// A map of std::string keys, looked up through std::string_view with a transparent hash, and a map
+// whose hash sends every key to one of a few values, so that probes run across many full groups
+// and erases leave tombstones, are driven by random inserts, assignments, erases and lookups and
+// checked against a std::unordered_map. --bench fills a table of 1M slots with random 64-bit keys
+// to load factors 0.5, 0.625, 0.75 and 0.875 and times inserts, hits and misses at each, next to a
+// std::unordered_map holding the same keys.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "prelude/structs/hash_map.hpp"
+
+namespace {
+
+bool g_failed = false;
+
+void check(bool cond, char const* what) {
+    if (!cond && !g_failed) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        g_failed = true;
+    }
+}
+
+struct string_hash {
+    using is_transparent = void;
+
+    std::size_t operator ()(std::string_view key) const noexcept {
+        return std::hash<std::string_view>()(key);
+    }
+};
+
+// Every key lands on one of eight hashes, so a handful of groups take all the probes.
+struct clustered_hash {
+    std::size_t operator ()(long key) const noexcept {
+        return std::size_t(key % 8);
+    }
+};
+
+template<typename Map, typename Ref>
+bool same(Map const& map, Ref const& ref) {
+    if (map.size() != ref.size()) {
+        return false;
+    }
+    auto count = 0uz;
+    for (auto const& entry : map) {
+        auto const it = ref.find(entry.key);
+        if (it == ref.end() || it->second != entry.value) {
+            return false;
+        }
+        ++count;
+    }
+    return count == ref.size();
+}
+
+template<typename Map, typename Key>
+void fuzz(char const* name, std::mt19937_64& rng, Key (*make_key)(unsigned long long)) {
+    auto map = Map();
+    auto ref = std::unordered_map<Key, long>();
+    for (int op = 0; op < 100'000 && !g_failed; ++op) {
+        // Alternate between growing to a few thousand keys and erasing most of them again.
+        auto const growing = (op / 10'000) % 2 == 0;
+        auto const key = make_key(rng() % 4'000);
+        auto const value = long(rng() % 1'000'000);
+        switch (growing ? rng() % 6 : rng() % 4 == 0 ? 3 : 2) {
+        case 0: case 4:
+            check(map.insert(key, value) == ref.emplace(key, value).second, "insert disagreed on presence");
+            break;
+        case 1: case 5:
+            check(map.insert_or_assign(key, value) == ref.insert_or_assign(key, value).second, "insert_or_assign disagreed on presence");
+            break;
+        case 2:
+            check(map.erase(key) == (ref.erase(key) == 1), "erase disagreed on presence");
+            break;
+        case 3: {
+            auto const* found = [&] {
+                if constexpr (Map::k_transparent) {
+                    return map.find(std::string_view(key));
+                }
+                else {
+                    return map.find(key);
+                }
+            }();
+            auto const expected = ref.find(key);
+            check(expected == ref.end() ? found == nullptr : found != nullptr && *found == expected->second, "find disagreed");
+            break;
+        }
+        }
+        if (op % 5'000 == 4'999) {
+            if (!same(map, ref)) {
+                std::fprintf(stderr, "FAILED: %s diverged from std::unordered_map at operation %d\n", name, op);
+                g_failed = true;
+            }
+            auto copy = map;
+            check(same(copy, ref), "copy diverged");
+            check(map.load_factor() <= 0.875, "load factor above 7/8");
+        }
+    }
+    std::printf("%s: final size %zu\n", name, std::size_t(ref.size()));
+}
+
+std::string string_key(unsigned long long i) {
+    // Longer than any small-string buffer, so each key owns heap memory.
+    return "key-" + std::to_string(i) + std::string(24, 'x');
+}
+
+long long_key(unsigned long long i) {
+    return long(i);
+}
+
+template<typename F>
+double ns_per(prelude::size_t n, F&& f) {
+    auto const start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / double(n);
+}
+
+void bench(std::mt19937_64& rng) {
+    constexpr prelude::size_t capacity = 1 << 20;
+    for (auto load : { 0.5, 0.625, 0.75, 0.875 }) {
+        auto const n = prelude::size_t(double(capacity) * load);
+        auto keys = std::vector<unsigned long long>(n);
+        auto misses = std::vector<unsigned long long>(n);
+        for (auto i = 0uz; i < n; ++i) {
+            // Odd keys are inserted and even keys are misses.
+            keys[i] = rng() | 1;
+            misses[i] = rng() & ~1ull;
+        }
+        auto map = prelude::hash_map<unsigned long long, unsigned long long>();
+        map.reserve(capacity - capacity / 8);
+        auto ref = std::unordered_map<unsigned long long, unsigned long long>();
+        ref.reserve(n);
+
+        unsigned long long sums[2] = {};
+        auto const insert = ns_per(n, [&] {
+            for (auto key : keys) {
+                map.insert(key, key);
+            }
+        });
+        auto const ref_insert = ns_per(n, [&] {
+            for (auto key : keys) {
+                ref.emplace(key, key);
+            }
+        });
+        check(map.capacity() == capacity, "the table grew during the benchmark");
+        auto const hit = ns_per(n, [&] {
+            for (auto i = n; i-- > 0; ) {
+                sums[0] += *map.find(keys[i]);
+            }
+        });
+        auto const ref_hit = ns_per(n, [&] {
+            for (auto i = n; i-- > 0; ) {
+                sums[1] += ref.find(keys[i])->second;
+            }
+        });
+        auto const miss = ns_per(n, [&] {
+            for (auto key : misses) {
+                sums[0] += map.find(key) != nullptr;
+            }
+        });
+        auto const ref_miss = ns_per(n, [&] {
+            for (auto key : misses) {
+                sums[1] += ref.find(key) != ref.end();
+            }
+        });
+        check(sums[0] == sums[1], "hash_map and std::unordered_map disagree");
+        std::printf("load %.3f, ns per op, hash_map / std::unordered_map: insert %.1f / %.1f, hit %.1f / %.1f, miss %.1f / %.1f\n",
+            map.load_factor(), insert, ref_insert, hit, ref_hit, miss, ref_miss);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto rng = std::mt19937_64(21);
+    fuzz<prelude::hash_map<std::string, long, string_hash, std::equal_to<>>>("hash_map<std::string>", rng, string_key);
+    fuzz<prelude::hash_map<long, long, clustered_hash>>("hash_map<long, clustered_hash>", rng, long_key);
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        bench(rng);
+    }
+    return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
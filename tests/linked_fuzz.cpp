@@ -0,0 +1,246 @@
+// Randomized differential test of the unrolled list functions and of sort in linked.hpp, plus a
+// timing run.
+//
+//     g++ -std=c++23 -O1 -g -fsanitize=address,undefined -Iinclude tests/linked_fuzz.cpp -o linked_fuzz
+//     g++ -std=c++23 -O2 -DNDEBUG -Iinclude tests/linked_fuzz.cpp -o linked_fuzz && ./linked_fuzz --bench
+//
+// An unrolled list is driven by random push_front, insert_after and remove_after calls at random
+// positions, and checked against a std::vector after every step, through size, nth and a walk of
+// the nodes, which must all be cache-line aligned. The elements are long std::strings so that
+// the relocations on split and refill are checked under the sanitizers. sort is checked against
+// std::stable_sort on doubly linked lists of random, sorted, reverse-sorted and sawtooth keys, with
+// many duplicates, including the prev links. --bench builds 1M ints as singly_linked_nodes and as
+// unrolled_nodes and times size, nth and a summing iteration over both, then times sort on random,
+// sorted and reverse-sorted lists of 10^3 to 10^7 nodes.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "prelude/structs/linked.hpp"
+
+namespace {
+
+static_assert(sizeof(prelude::unrolled_node<int>) == prelude::k_cache_line_size);
+static_assert(alignof(prelude::unrolled_node<std::string, 4>) == prelude::k_cache_line_size);
+
+bool g_failed = false;
+
+void check(bool cond, char const* what) {
+    if (!cond && !g_failed) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        g_failed = true;
+    }
+}
+
+template<typename T, prelude::size_t N>
+bool same(prelude::unrolled_node<T, N>* head, std::vector<T> const& ref) {
+    auto i = 0uz;
+    for (auto* node = head; node != nullptr; node = node->next) {
+        if (node->count == 0 || node->count > N || reinterpret_cast<unsigned long long>(node) % prelude::k_cache_line_size != 0) {
+            return false;
+        }
+        for (auto j = 0uz; j < node->count; ++j) {
+            if (i == ref.size() || (*node)[j] != ref[i++]) {
+                return false;
+            }
+        }
+    }
+    return i == ref.size() && prelude::size(head) == ref.size();
+}
+
+template<prelude::size_t N>
+void unrolled_round(char const* name, std::mt19937_64& rng) {
+    using node_type = prelude::unrolled_node<std::string, N>;
+    node_type* head = nullptr;
+    auto ref = std::vector<std::string>();
+    for (int op = 0; op < 20'000 && !g_failed; ++op) {
+        // Alternate between growing to a few hundred elements and shrinking to a handful.
+        auto const limit = (op / 1000) % 2 == 0 ? 200uz : 8uz;
+        auto value = std::string(24, char('a' + rng() % 26)) + std::to_string(op);
+        auto const at = ref.empty() ? 0 : rng() % ref.size();
+        switch (ref.empty() ? 0 : rng() % (ref.size() < limit ? 3 : 5)) {
+        case 0:
+            head = prelude::push_front(head, value);
+            ref.insert(ref.begin(), value);
+            break;
+        case 1: case 2:
+            prelude::insert_after(prelude::nth(head, at), value);
+            ref.insert(ref.begin() + long(at) + 1, value);
+            break;
+        default:
+            if (at + 1 < ref.size()) {
+                prelude::remove_after(prelude::nth(head, at));
+                ref.erase(ref.begin() + long(at) + 1);
+            }
+            break;
+        }
+        if (!same(head, ref)) {
+            std::fprintf(stderr, "FAILED: %s diverged from std::vector at operation %d\n", name, op);
+            g_failed = true;
+        }
+        auto const probe = ref.empty() ? 0 : rng() % ref.size();
+        auto const pos = prelude::nth(head, probe);
+        check(ref.empty() || (*pos.node)[pos.index] == ref[probe], "nth returned the wrong element");
+    }
+    prelude::clear(head);
+}
+
+enum class order { random, sorted, reverse, sawtooth };
+
+std::vector<unsigned> make_keys(std::mt19937_64& rng, prelude::size_t n, order kind, unsigned range) {
+    auto keys = std::vector<unsigned>(n);
+    for (auto i = 0uz; i < n; ++i) {
+        switch (kind) {
+        case order::random: keys[i] = unsigned(rng() % range); break;
+        case order::sorted: keys[i] = unsigned(i); break;
+        case order::reverse: keys[i] = unsigned(n - i); break;
+        case order::sawtooth: keys[i] = unsigned(i % 37); break;
+        }
+    }
+    return keys;
+}
+
+void sort_round(std::mt19937_64& rng) {
+    // The key is compared, the sequence number checks stability.
+    using node_type = prelude::doubly_linked_node<std::pair<unsigned, prelude::size_t>>;
+    auto by_key = [](auto const& a, auto const& b) { return a.first < b.first; };
+    for (auto n : { 0uz, 1uz, 2uz, 3uz, 17uz, 64uz, 65uz, 1000uz, 4099uz }) {
+        for (auto kind : { order::random, order::sorted, order::reverse, order::sawtooth }) {
+            auto const keys = make_keys(rng, n, kind, 8);
+            auto nodes = std::vector<node_type>(n);
+            auto ref = std::vector<std::pair<unsigned, prelude::size_t>>(n);
+            for (auto i = 0uz; i < n; ++i) {
+                ref[i] = { keys[i], i };
+                nodes[i] = { ref[i], i + 1 < n ? &nodes[i + 1] : nullptr, i > 0 ? &nodes[i - 1] : nullptr };
+            }
+            auto* head = prelude::sort(n > 0 ? nodes.data() : nullptr, by_key);
+            std::stable_sort(ref.begin(), ref.end(), by_key);
+            auto i = 0uz;
+            node_type* prev = nullptr;
+            for (auto* it = head; it != nullptr; prev = it, it = it->next) {
+                check(i < n && it->data == ref[i++], "sort produced the wrong order or was not stable");
+                check(it->prev == prev, "sort left a stale prev link");
+            }
+            check(i == n, "sort lost nodes");
+        }
+    }
+}
+
+template<typename F>
+double time_ms(F&& f) {
+    auto const start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void bench() {
+    constexpr int n = 1 << 20;
+    constexpr int passes = 20;
+    using single_type = prelude::singly_linked_node<int>;
+    using unrolled_type = prelude::unrolled_node<int>;
+
+    auto alloc = prelude::node_allocator<single_type>();
+    single_type* singles = nullptr;
+    for (int i = n; i-- > 0; ) {
+        singles = alloc.new_object(i, singles);
+    }
+    auto* unrolled = prelude::push_front<int>(static_cast<unrolled_type*>(nullptr), 0);
+    auto tail = prelude::unrolled_position<int, prelude::k_unrolled_capacity<int>> { unrolled, 0 };
+    for (int i = 1; i < n; ++i) {
+        tail = prelude::insert_after(tail, i);
+    }
+
+    auto sums = 0ll;
+    auto const single_size = time_ms([&] {
+        for (int p = 0; p < passes; ++p) {
+            sums += prelude::size(singles);
+        }
+    });
+    auto const unrolled_size = time_ms([&] {
+        for (int p = 0; p < passes; ++p) {
+            sums -= prelude::size(unrolled);
+        }
+    });
+    auto const single_nth = time_ms([&] {
+        for (int p = 0; p < passes; ++p) {
+            sums += prelude::nth(singles, n - 1)->data;
+        }
+    });
+    auto const unrolled_nth = time_ms([&] {
+        for (int p = 0; p < passes; ++p) {
+            auto const pos = prelude::nth(unrolled, n - 1);
+            sums -= (*pos.node)[pos.index];
+        }
+    });
+    auto const single_sum = time_ms([&] {
+        for (int p = 0; p < passes; ++p) {
+            for (auto* it = singles; it != nullptr; it = it->next) {
+                sums += it->data;
+            }
+        }
+    });
+    auto const unrolled_sum = time_ms([&] {
+        for (int p = 0; p < passes; ++p) {
+            for (auto* it = unrolled; it != nullptr; it = it->next) {
+                for (auto j = 0uz; j < it->count; ++j) {
+                    sums -= (*it)[j];
+                }
+            }
+        }
+    });
+    check(sums == 0, "singly linked and unrolled lists disagree");
+    std::printf("1M ints, %d passes, one element per node / unrolled by %zu:\n", passes, std::size_t(prelude::k_unrolled_capacity<int>));
+    std::printf("  size %.1f / %.1f ms, nth(last) %.1f / %.1f ms, iteration %.1f / %.1f ms\n",
+        single_size, unrolled_size, single_nth, unrolled_nth, single_sum, unrolled_sum);
+
+    while (singles != nullptr) {
+        auto* next = singles->next;
+        alloc.deallocate(singles, 1);
+        singles = next;
+    }
+    prelude::clear(unrolled);
+
+    using node_type = prelude::singly_linked_node<unsigned>;
+    auto rng = std::mt19937_64(17);
+    auto less = [](unsigned a, unsigned b) { return a < b; };
+    for (auto size : { 1'000uz, 10'000uz, 100'000uz, 1'000'000uz, 10'000'000uz }) {
+        // Small lists are sorted repeatedly so the timings are long enough to read.
+        auto const reps = std::max(1uz, 1'000'000uz / size);
+        auto nodes = std::vector<node_type>(size);
+        double ms[3] = {};
+        for (auto kind : { order::random, order::sorted, order::reverse }) {
+            for (auto rep = 0uz; rep < reps; ++rep) {
+                auto const keys = make_keys(rng, size, kind, ~0u);
+                for (auto i = 0uz; i < size; ++i) {
+                    nodes[i] = { keys[i], i + 1 < size ? &nodes[i + 1] : nullptr };
+                }
+                node_type* head = nullptr;
+                ms[int(kind)] += time_ms([&] { head = prelude::sort(nodes.data(), less); });
+                check(prelude::size(head) == size, "sort lost nodes");
+            }
+            ms[int(kind)] /= double(reps);
+        }
+        std::printf("sort %zu nodes: random %.3f ms, sorted %.3f ms, reverse %.3f ms\n", std::size_t(size), ms[0], ms[1], ms[2]);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto rng = std::mt19937_64(13);
+    unrolled_round<1>("unrolled_node<1>", rng);
+    unrolled_round<4>("unrolled_node<4>", rng);
+    unrolled_round<7>("unrolled_node<7>", rng);
+    sort_round(rng);
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        bench();
+    }
+    return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
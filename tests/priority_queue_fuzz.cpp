@@ -0,0 +1,178 @@
+// Randomized differential test of priority_queue and indexed_priority_queue, plus a timing run.
+//
+//     g++ -std=c++23 -O1 -g -fsanitize=address,undefined -Iinclude tests/priority_queue_fuzz.cpp -o pq_fuzz
+//     g++ -std=c++23 -O2 -DNDEBUG -Iinclude tests/priority_queue_fuzz.cpp -o pq_fuzz && ./pq_fuzz --bench
+//
+// priority_queue is checked against std::priority_queue, and indexed_priority_queue against a plain
+// array of live handles that is scanned for the maximum after every operation. --bench pushes and
+// pops 4M random 32-bit keys through binary and 4-ary heaps and std::priority_queue.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "prelude/adts/queue.hpp"
+
+namespace {
+
+bool g_failed = false;
+
+void check(bool cond, char const* what) {
+    if (!cond && !g_failed) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        g_failed = true;
+    }
+}
+
+void plain_round(std::mt19937_64& rng) {
+    auto queue = prelude::priority_queue<std::string>();
+    auto ref = std::priority_queue<std::string>();
+    for (int op = 0; op < 100'000 && !g_failed; ++op) {
+        auto value = std::to_string(rng() % 100'000) + std::string(20, 'x');
+        switch (ref.empty() ? 0 : rng() % 5) {
+        case 0: case 1:
+            queue.push(value);
+            ref.push(value);
+            break;
+        case 2:
+            queue.pop();
+            ref.pop();
+            break;
+        case 3:
+            ref.push(value);
+            check(queue.push_pop(value) == ref.top(), "push_pop returned the wrong element");
+            ref.pop();
+            break;
+        case 4:
+            check(queue.replace_top(value) == ref.top(), "replace_top returned the wrong element");
+            ref.pop();
+            ref.push(value);
+            break;
+        }
+        check(queue.size() == ref.size(), "priority_queue size diverged");
+        check(ref.empty() || queue.top() == ref.top(), "priority_queue top diverged");
+    }
+
+    // from_range heapifies in place; draining it must give the keys in sorted order.
+    auto keys = std::vector<int>(100'000);
+    for (auto& key : keys) {
+        key = int(rng());
+    }
+    auto heap = prelude::priority_queue<int, prelude::array_list<int>, std::greater<int>, 3>::from_range(keys.begin(), keys.end());
+    std::sort(keys.begin(), keys.end());
+    for (auto key : keys) {
+        check(heap.top() == key, "from_range heap drained out of order");
+        heap.pop();
+    }
+    check(heap.is_empty(), "from_range heap not empty after draining");
+    std::printf("priority_queue: ok\n");
+}
+
+void indexed_round(std::mt19937_64& rng) {
+    using queue_type = prelude::indexed_priority_queue<int>;
+    auto queue = queue_type();
+    auto values = std::vector<int>();
+    auto live = std::vector<bool>();
+    auto count = 0uz;
+
+    for (int op = 0; op < 20'000 && !g_failed; ++op) {
+        auto const kind = count == 0 ? 0 : rng() % 6;
+        if (kind < 2) {
+            auto const value = int(rng() % 100'000);
+            auto const handle = queue.push(value);
+            if (handle >= values.size()) {
+                values.resize(handle + 1);
+                live.resize(handle + 1);
+            }
+            check(!live[handle], "push reused a live handle");
+            values[handle] = value;
+            live[handle] = true;
+            ++count;
+        }
+        else if (kind == 2) {
+            auto const handle = queue.top_handle();
+            check(live[handle] && values[handle] == queue.top(), "top_handle does not match top");
+            live[handle] = false;
+            --count;
+            queue.pop();
+        }
+        else {
+            auto handle = queue_type::handle_type();
+            do {
+                handle = rng() % values.size();
+            } while (!live[handle]);
+            check(queue.contains(handle) && queue[handle] == values[handle], "lookup by handle diverged");
+            if (kind == 3) {
+                // With std::less the top is the largest, so raising a key moves it towards the top.
+                values[handle] += int(rng() % 100);
+                queue.decrease_key(handle, values[handle]);
+            }
+            else if (kind == 4) {
+                values[handle] = int(rng() % 100'000);
+                queue.update(handle, values[handle]);
+            }
+            else {
+                queue.erase(handle);
+                live[handle] = false;
+                --count;
+                check(!queue.contains(handle), "erased handle still contained");
+            }
+        }
+
+        auto best = -1;
+        for (auto h = 0uz; h < values.size(); ++h) {
+            if (live[h] && values[h] > best) {
+                best = values[h];
+            }
+        }
+        check(queue.size() == count, "indexed_priority_queue size diverged");
+        check(count == 0 || queue.top() == best, "indexed_priority_queue top diverged");
+    }
+    std::printf("indexed_priority_queue: ok\n");
+}
+
+template<typename Queue>
+double time_drain(std::vector<unsigned> const& keys, unsigned long long& checksum) {
+    auto const start = std::chrono::steady_clock::now();
+    auto queue = Queue();
+    for (auto key : keys) {
+        queue.push(key);
+    }
+    while (!queue.empty()) {
+        checksum = checksum * 31 + queue.top();
+        queue.pop();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void bench(std::mt19937_64& rng) {
+    auto keys = std::vector<unsigned>(1 << 22);
+    for (auto& key : keys) {
+        key = unsigned(rng());
+    }
+    auto sums = std::vector<unsigned long long>(3);
+    auto const binary = time_drain<prelude::priority_queue<unsigned, prelude::array_list<unsigned>, std::less<unsigned>, 2>>(keys, sums[0]);
+    auto const quaternary = time_drain<prelude::priority_queue<unsigned>>(keys, sums[1]);
+    auto const standard = time_drain<std::priority_queue<unsigned>>(keys, sums[2]);
+    check(sums[0] == sums[2] && sums[1] == sums[2], "heaps drained in different orders");
+    std::printf("4M u32 push+pop: binary %.0f ms, 4-ary %.0f ms, std::priority_queue %.0f ms\n", binary, quaternary, standard);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto rng = std::mt19937_64(23);
+    plain_round(rng);
+    indexed_round(rng);
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        bench(rng);
+    }
+    return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
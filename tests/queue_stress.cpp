@@ -0,0 +1,224 @@
+// Multi-threaded stress test for the lock-free bounded queues.
+//
+//     g++ -std=c++23 -O1 -g -fsanitize=thread -Iinclude tests/queue_stress.cpp -o queue_stress
+//     g++ -std=c++23 -O1 -g -fsanitize=address,undefined -Iinclude tests/queue_stress.cpp -o queue_stress
+//     g++ -std=c++23 -O2 -DNDEBUG -Iinclude tests/queue_stress.cpp -o queue_stress && ./queue_stress --bench
+//
+// The queues are kept small so that producers keep running into a full queue and consumers into an
+// empty one. The values carry their producer and sequence number, so a consumer can check that each
+// producer's values arrive in order, and the totals check that nothing is lost or delivered twice.
+// --bench moves 4M longs from producers to consumers, split evenly over 2 to 64 threads, through
+// mpmc_queue and through a prelude::queue guarded by a std::mutex.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "prelude/adts/queue.hpp"
+
+namespace {
+
+std::atomic<bool> g_failed = false;
+
+void check(bool cond, char const* what) {
+    if (!cond && !g_failed.exchange(true)) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+    }
+}
+
+// One producer, one consumer, single and batched operations, std::string elements.
+void spsc_round() {
+    constexpr long count = 200'000;
+    auto queue = prelude::spsc_queue<std::string>(64);
+
+    auto producer = std::thread([&] {
+        auto next = 0l;
+        while (next < count) {
+            if (next % 3 == 0) {
+                std::string batch[8];
+                auto n = 0uz;
+                for (; n < 8 && next + long(n) < count; ++n) {
+                    batch[n] = std::to_string(next + long(n));
+                }
+                next += long(queue.push_n(batch, n));
+            }
+            else if (queue.push(std::to_string(next))) {
+                ++next;
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    auto expected = 0l;
+    while (expected < count) {
+        if (expected % 5 == 0) {
+            std::string batch[8];
+            auto const n = queue.pop_n(batch, 8);
+            if (n == 0) {
+                std::this_thread::yield();
+            }
+            for (auto i = 0uz; i < n; ++i) {
+                check(batch[i] == std::to_string(expected++), "spsc_queue out of order");
+            }
+        }
+        else {
+            auto out = std::string();
+            if (queue.try_pop(out)) {
+                check(out == std::to_string(expected++), "spsc_queue out of order");
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+    producer.join();
+    check(queue.is_empty(), "spsc_queue not empty after draining");
+    std::printf("spsc_queue: %ld elements\n", count);
+}
+
+// Four producers and four consumers; each value encodes its producer and its sequence number.
+void mpmc_round() {
+    constexpr int producers = 4;
+    constexpr int consumers = 4;
+    constexpr long per_producer = 50'000;
+    auto queue = prelude::mpmc_queue<long>(32);
+    auto received = std::atomic<long>(0);
+    auto sum = std::atomic<long>(0);
+
+    auto pool = std::vector<std::thread>();
+    for (int p = 0; p < producers; ++p) {
+        pool.emplace_back([&, p] {
+            for (long i = 0; i < per_producer; ++i) {
+                auto const value = long(p) * per_producer + i;
+                if (i % 2 == 0) {
+                    queue.push(value);
+                }
+                else {
+                    while (!queue.try_push(value)) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        pool.emplace_back([&] {
+            // A consumer sees each producer's values in the order they were pushed.
+            long last[producers];
+            for (auto& l : last) {
+                l = -1;
+            }
+            while (received.load(std::memory_order_relaxed) < producers * per_producer) {
+                auto value = 0l;
+                if (!queue.try_pop(value)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                auto const p = value / per_producer;
+                check(value % per_producer > last[p], "mpmc_queue reordered a producer's values");
+                last[p] = value % per_producer;
+                sum += value;
+                ++received;
+            }
+        });
+    }
+    for (auto& th : pool) {
+        th.join();
+    }
+    auto const total = long(producers) * per_producer;
+    check(received == total, "mpmc_queue lost or duplicated a value");
+    check(sum == total * (total - 1) / 2, "mpmc_queue delivered wrong values");
+    std::printf("mpmc_queue: %d x %d, %ld elements\n", producers, consumers, total);
+}
+
+// The usual alternative to mpmc_queue: the single-threaded adapter behind one lock.
+class locked_queue {
+public:
+    explicit locked_queue(prelude::size_t) {}
+
+    bool try_push(long value) {
+        auto guard = std::lock_guard(m_lock);
+        m_queue.push(value);
+        return true;
+    }
+
+    bool try_pop(long& out) {
+        auto guard = std::lock_guard(m_lock);
+        if (m_queue.is_empty()) {
+            return false;
+        }
+        out = m_queue.top();
+        m_queue.pop();
+        return true;
+    }
+
+private:
+    std::mutex m_lock;
+    prelude::queue<long> m_queue;
+};
+
+template<typename Queue>
+double time_transfer(int producers, int consumers, long total) {
+    auto queue = Queue(1024);
+    auto received = std::atomic<long>(0);
+    auto sum = std::atomic<long>(0);
+    auto const start = std::chrono::steady_clock::now();
+    auto pool = std::vector<std::thread>();
+    for (int p = 0; p < producers; ++p) {
+        pool.emplace_back([&, p] {
+            for (long i = p; i < total; i += producers) {
+                while (!queue.try_push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        pool.emplace_back([&] {
+            auto local = 0l;
+            while (received.load(std::memory_order_relaxed) < total) {
+                auto value = 0l;
+                if (!queue.try_pop(value)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                local += value;
+                received.fetch_add(1, std::memory_order_relaxed);
+            }
+            sum += local;
+        });
+    }
+    for (auto& th : pool) {
+        th.join();
+    }
+    check(sum == total * (total - 1) / 2, "benchmark queue delivered wrong values");
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void bench() {
+    constexpr long total = 1 << 22;
+    for (int threads = 2; threads <= 64; threads *= 2) {
+        auto const lock_free = time_transfer<prelude::mpmc_queue<long>>(threads / 2, threads / 2, total);
+        auto const locked = time_transfer<locked_queue>(threads / 2, threads / 2, total);
+        std::printf("4M longs, %d threads: mpmc_queue %.0f ms, locked queue %.0f ms\n", threads, lock_free, locked);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    spsc_round();
+    mpmc_round();
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        bench();
+    }
+    return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
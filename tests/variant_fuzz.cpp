@@ -0,0 +1,332 @@
+// Randomized differential test of variant against std::variant, plus a timing run.
+//
+//     g++ -std=c++23 -O1 -g -fsanitize=address,undefined -Iinclude tests/variant_fuzz.cpp -o variant_fuzz
+//     g++ -std=c++23 -O2 -DNDEBUG -Iinclude tests/variant_fuzz.cpp -o variant_fuzz && ./variant_fuzz --bench
+//
+// A variant of three alternatives, which dispatches through a switch, and one of twelve, which
+// dispatches through a table of function pointers, are driven by random assignments, emplaces,
+// copies, moves and destroys over a few slots, and checked against a std::variant with a leading
+// std::monostate standing in for the empty state. Most alternatives hold long std::strings, so that
+// a destructor run on the wrong alternative shows up under the sanitizers. Visiting two and three
+// variants at once is checked against std::visit. Variants of trivially copyable alternatives must
+// be trivially copyable themselves, survive a memcpy, and keep their index in the tail padding.
+// --bench sums 1M variants of 3 and of 16 alternatives through visit and through std::visit.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "prelude/structs/variant.hpp"
+
+namespace {
+
+constexpr auto twice = []<prelude::size_t I>(prelude::constexpr_size<I>) { return I * 2; };
+constexpr auto digits = []<prelude::size_t... I>(prelude::constexpr_size<I>...) {
+    auto result = prelude::size_t(0);
+    ((result = result * 10 + I), ...);
+    return result;
+};
+
+static_assert(prelude::dispatch<3>(2, twice) == 4);
+static_assert(prelude::dispatch<20>(17, twice) == 34);
+static_assert(prelude::dispatch_flat<3, 4, 5>(digits, 2, 1, 4) == 214);
+static_assert(prelude::dispatch_flat<9, 2>(digits, 8, 1) == 81);
+static_assert(prelude::variant<int, long>().is_empty());
+
+// The index sits in the padding after the largest alternative.
+static_assert(sizeof(prelude::variant<int, char[5]>) == 8);
+static_assert(sizeof(prelude::variant<char, short>) == 4);
+static_assert(sizeof(prelude::variant<double, int>) == 16);
+
+static_assert(std::is_trivially_copyable_v<prelude::variant<int, double, char[5]>>);
+static_assert(std::is_trivially_destructible_v<prelude::variant<int, double, char[5]>>);
+static_assert(!std::is_trivially_copyable_v<prelude::variant<int, std::string>>);
+static_assert(!std::is_trivially_destructible_v<prelude::variant<int, std::string>>);
+
+bool g_failed = false;
+
+void check(bool cond, char const* what) {
+    if (!cond && !g_failed) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        g_failed = true;
+    }
+}
+
+template<int K>
+struct tagged {
+    std::string text;
+
+    bool operator ==(tagged const&) const = default;
+};
+
+template<typename T>
+T make(std::mt19937_64& rng) {
+    if constexpr (std::is_arithmetic_v<T>) {
+        return T(rng() % 1000);
+    }
+    else {
+        // Longer than any small-string buffer, so each value owns heap memory.
+        return T { std::string(24, char('a' + rng() % 26)) + std::to_string(rng() % 1000) };
+    }
+}
+
+std::string describe(std::monostate) {
+    return "empty";
+}
+
+std::string describe(std::string const& value) {
+    return value;
+}
+
+std::string describe(int value) {
+    return std::to_string(value);
+}
+
+std::string describe(double value) {
+    return std::to_string(value);
+}
+
+template<int K>
+std::string describe(tagged<K> const& value) {
+    return std::to_string(K) + ":" + value.text;
+}
+
+template<typename... Ts>
+bool same(prelude::variant<Ts...> const& var, std::variant<std::monostate, Ts...> const& ref) {
+    if (var.is_empty()) {
+        return ref.index() == 0;
+    }
+    if (var.index() + 1 != ref.index()) {
+        return false;
+    }
+    return var.visit([&]<typename T>(T const& value) { return std::get<T>(ref) == value; });
+}
+
+template<typename... Ts>
+void fuzz(char const* name, std::mt19937_64& rng) {
+    using variant_type = prelude::variant<Ts...>;
+    using ref_type = std::variant<std::monostate, Ts...>;
+    constexpr int slots = 4;
+    variant_type vars[slots];
+    ref_type refs[slots];
+    for (int op = 0; op < 100'000 && !g_failed; ++op) {
+        auto const i = rng() % slots;
+        auto const j = rng() % slots;
+        auto const k = rng() % sizeof...(Ts);
+        switch (rng() % 8) {
+        case 0: case 1:
+            prelude::dispatch<sizeof...(Ts)>(k, [&]<prelude::size_t I>(prelude::constexpr_size<I>) {
+                auto const value = make<typename variant_type::template alternative_type<I>>(rng);
+                vars[i] = value;
+                refs[i].template emplace<I + 1>(value);
+            });
+            break;
+        case 2:
+            prelude::dispatch<sizeof...(Ts)>(k, [&]<prelude::size_t I>(prelude::constexpr_size<I>) {
+                using T = variant_type::template alternative_type<I>;
+                auto value = make<T>(rng);
+                refs[i].template emplace<I + 1>(value);
+                check(vars[i].template emplace<T>(std::move(value)) == std::get<I + 1>(refs[i]), "emplace returned the wrong value");
+            });
+            break;
+        case 3:
+            vars[i] = vars[j];
+            refs[i] = refs[j];
+            break;
+        case 4:
+            if (i != j) {
+                vars[i] = std::move(vars[j]);
+                refs[i] = std::move(refs[j]);
+            }
+            break;
+        case 5: {
+            auto copy = vars[j];
+            check(same(copy, refs[j]), "copy construction diverged");
+            auto moved = std::move(copy);
+            check(same(moved, refs[j]), "move construction diverged");
+            break;
+        }
+        case 6:
+            vars[i].destroy();
+            refs[i] = std::monostate();
+            break;
+        default:
+            prelude::dispatch<sizeof...(Ts)>(k, [&]<prelude::size_t I>(prelude::constexpr_size<I>) {
+                using T = variant_type::template alternative_type<I>;
+                auto const holds = refs[i].index() == I + 1;
+                check(vars[i].template is<T>() == holds, "is disagreed");
+                check((vars[i].template get_if<T>() != nullptr) == holds, "get_if disagreed");
+                auto threw = false;
+                try {
+                    auto const& value = vars[i].template get<T>();
+                    check(!holds || value == std::get<I + 1>(refs[i]), "get returned the wrong value");
+                }
+                catch (prelude::bad_variant_access const&) {
+                    threw = true;
+                }
+                check(threw != holds, "get threw on a match or returned on a mismatch");
+            });
+            break;
+        }
+        if (!same(vars[i], refs[i]) || !same(vars[j], refs[j])) {
+            std::fprintf(stderr, "FAILED: %s diverged from std::variant at operation %d\n", name, op);
+            g_failed = true;
+        }
+    }
+}
+
+template<typename... Vs, typename... Rs>
+void visit_many(Vs const&... vars, Rs const&... refs) {
+    auto const join = [](auto const&... values) {
+        return ((describe(values) + "|") + ...);
+    };
+    auto threw = false;
+    auto result = std::string();
+    try {
+        result = prelude::visit(join, vars...);
+    }
+    catch (prelude::bad_variant_access const&) {
+        threw = true;
+    }
+    auto const empty = ((refs.index() == 0) || ...);
+    check(threw == empty, "visit threw on full variants or returned on an empty one");
+    check(empty || result == std::visit(join, refs...), "visit called the wrong combination");
+}
+
+void visit_round(std::mt19937_64& rng) {
+    using small_type = prelude::variant<std::string, int, double>;
+    using large_type = prelude::variant<tagged<0>, tagged<1>, tagged<2>, tagged<3>, tagged<4>, tagged<5>,
+                                        tagged<6>, tagged<7>, tagged<8>, tagged<9>, int, std::string>;
+    auto const fill = [&]<typename V, typename R>(V& var, R& ref) {
+        // One time in eight the variant stays empty.
+        if (rng() % 8 == 0) {
+            return;
+        }
+        prelude::dispatch<V::k_size>(rng() % V::k_size, [&]<prelude::size_t I>(prelude::constexpr_size<I>) {
+            auto const value = make<typename V::template alternative_type<I>>(rng);
+            var = value;
+            ref.template emplace<I + 1>(value);
+        });
+    };
+    for (int round = 0; round < 10'000 && !g_failed; ++round) {
+        auto a = small_type();
+        auto b = large_type();
+        auto c = small_type();
+        auto ra = std::variant<std::monostate, std::string, int, double>();
+        auto rb = std::variant<std::monostate, tagged<0>, tagged<1>, tagged<2>, tagged<3>, tagged<4>, tagged<5>,
+                               tagged<6>, tagged<7>, tagged<8>, tagged<9>, int, std::string>();
+        auto rc = ra;
+        fill(a, ra);
+        fill(b, rb);
+        fill(c, rc);
+        visit_many<small_type, large_type>(a, b, ra, rb);
+        visit_many<large_type, small_type, small_type>(b, a, c, rb, ra, rc);
+    }
+}
+
+template<int K>
+struct number {
+    int value;
+};
+
+template<typename Seq>
+struct numbers;
+
+template<int... K>
+struct numbers<std::integer_sequence<int, K...>> {
+    using variant_type = prelude::variant<number<K>...>;
+    using ref_type = std::variant<number<K>...>;
+};
+
+void trivial_round(std::mt19937_64& rng) {
+    using variant_type = prelude::variant<int, double, number<0>, number<1>>;
+    constexpr int n = 1000;
+    auto vars = std::vector<variant_type>(n);
+    for (auto& var : vars) {
+        switch (rng() % 5) {
+        case 0: var = int(rng() % 1000); break;
+        case 1: var = double(rng() % 1000) / 8; break;
+        case 2: var = number<0> { int(rng() % 1000) }; break;
+        case 3: var = number<1> { int(rng() % 1000) }; break;
+        default: break;
+        }
+    }
+    // Trivially copyable, so a byte copy is a valid copy.
+    auto copies = std::vector<variant_type>(n);
+    std::memcpy(static_cast<void*>(copies.data()), vars.data(), n * sizeof(variant_type));
+    for (auto i = 0uz; i < n; ++i) {
+        auto const& var = vars[i];
+        auto const& copy = copies[i];
+        check(var.index() == copy.index(), "memcpy changed the index");
+        check(var.get_if<int>() == nullptr || *var.get_if<int>() == copy.get<int>(), "memcpy changed an int");
+        check(var.get_if<double>() == nullptr || *var.get_if<double>() == copy.get<double>(), "memcpy changed a double");
+        check(var.get_if<number<0>>() == nullptr || var.get_if<number<0>>()->value == copy.get<number<0>>().value, "memcpy changed a number");
+        check(var.get_if<number<1>>() == nullptr || var.get_if<number<1>>()->value == copy.get<number<1>>().value, "memcpy changed a number");
+    }
+}
+
+template<typename F>
+double time_ms(F&& f) {
+    auto const start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<int N>
+void bench(std::mt19937_64& rng) {
+    using variant_type = numbers<std::make_integer_sequence<int, N>>::variant_type;
+    using ref_type = numbers<std::make_integer_sequence<int, N>>::ref_type;
+    constexpr int n = 1 << 20;
+    constexpr int passes = 20;
+    auto vars = std::vector<variant_type>(n);
+    auto refs = std::vector<ref_type>(n);
+    for (auto i = 0uz; i < n; ++i) {
+        auto const value = int(rng() % 1000);
+        prelude::dispatch<N>(rng() % N, [&]<prelude::size_t I>(prelude::constexpr_size<I>) {
+            vars[i] = number<int(I)> { value };
+            refs[i] = number<int(I)> { value };
+        });
+    }
+    // Weighting each alternative differently keeps the compiler from merging the cases.
+    auto const weigh = []<int K>(number<K> const& x) { return (long long)(x.value) * (K + 1); };
+    long long sums[2] = {};
+    auto const visit_time = time_ms([&] {
+        for (int p = 0; p < passes; ++p) {
+            for (auto const& var : vars) {
+                sums[0] += prelude::visit(weigh, var);
+            }
+        }
+    });
+    auto const ref_time = time_ms([&] {
+        for (int p = 0; p < passes; ++p) {
+            for (auto const& ref : refs) {
+                sums[1] += std::visit(weigh, ref);
+            }
+        }
+    });
+    check(sums[0] == sums[1], "visit and std::visit disagree");
+    std::printf("1M variants of %d alternatives, %d passes, visit / std::visit: %.1f / %.1f ms\n", N, passes, visit_time, ref_time);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto rng = std::mt19937_64(24);
+    fuzz<std::string, int, double>("variant<std::string, int, double>", rng);
+    fuzz<tagged<0>, tagged<1>, tagged<2>, tagged<3>, tagged<4>, tagged<5>,
+         tagged<6>, tagged<7>, tagged<8>, tagged<9>, int, std::string>("variant of 12 alternatives", rng);
+    visit_round(rng);
+    trivial_round(rng);
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        bench<3>(rng);
+        bench<16>(rng);
+    }
+    return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}